@@ -0,0 +1,129 @@
+// Read latency while the database is being hammered with writes.
+//
+// Measures get() latency on its own and then again during a storm of
+// concurrent put()s, printing p50/p99/max for both. Writes used to sit in
+// the libuv threadpool blocked on the LMDB writer lock, starving reads of
+// threads; run this against builds from before and after the dedicated
+// writer thread to compare the read tail.
+
+const leveldown   = require('../')
+    , crypto      = require('crypto')
+    , rimraf      = require('rimraf')
+
+    , keyCount    = 100000
+    , readCount   = 50000
+    , readConc    = 16
+    , writeConc   = 64
+    , dbDir       = './read_during_writes.db'
+    , data        = crypto.randomBytes(256) // buffer
+
+var db = leveldown(dbDir)
+
+function key (i) {
+  return 'key' + ('000000000' + i).slice(-9)
+}
+
+function percentile (sorted, p) {
+  return sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * p))]
+}
+
+function report (label, times) {
+  times.sort(function (a, b) { return a - b })
+  console.log(
+      label
+    , 'p50:', percentile(times, 0.5).toFixed(3) + 'ms'
+    , 'p99:', percentile(times, 0.99).toFixed(3) + 'ms'
+    , 'max:', times[times.length - 1].toFixed(3) + 'ms'
+  )
+}
+
+function populate (callback) {
+  var i = 0
+
+  function next () {
+    if (i >= keyCount)
+      return callback()
+
+    var ops = []
+    for (var end = Math.min(i + 1000, keyCount); i < end; i++)
+      ops.push({ type: 'put', key: key(i), value: data })
+
+    db.batch(ops, function (err) {
+      if (err)
+        throw err
+      next()
+    })
+  }
+
+  next()
+}
+
+function reads (callback) {
+  var times   = []
+    , started = 0
+    , done    = 0
+
+  function read () {
+    if (started >= readCount)
+      return
+    started++
+
+    var time = process.hrtime()
+    db.get(key(Math.floor(Math.random() * keyCount)), function (err) {
+      if (err)
+        throw err
+
+      var diff = process.hrtime(time)
+      times.push(diff[0] * 1e3 + diff[1] / 1e6)
+
+      if (++done == readCount)
+        return callback(times)
+      read()
+    })
+  }
+
+  for (var i = 0; i < readConc; i++)
+    read()
+}
+
+function writeStorm () {
+  var stopped = false
+    , i       = keyCount
+
+  function write () {
+    if (stopped)
+      return
+    db.put(key(i++), data, function (err) {
+      if (err)
+        throw err
+      write()
+    })
+  }
+
+  for (var j = 0; j < writeConc; j++)
+    write()
+
+  return function stop () { stopped = true }
+}
+
+rimraf.sync(dbDir)
+
+db.open({ mapSize: 1024 << 20, sync: false }, function (err) {
+  if (err)
+    throw err
+
+  populate(function () {
+    reads(function (times) {
+      report('reads, idle:       ', times)
+
+      var stop = writeStorm()
+      reads(function (times) {
+        stop()
+        report('reads, write storm:', times)
+        db.close(function () {
+          rimraf.sync(dbDir)
+        })
+      })
+    })
+  })
+})
@@ -30,12 +30,16 @@
       , "sources": [
             "src/batch.cc"
           , "src/batch_async.cc"
+          , "src/builder.cc"
+          , "src/builder_async.cc"
           , "src/database.cc"
           , "src/database_async.cc"
+          , "src/filter.cc"
           , "src/iterator.cc"
           , "src/iterator_async.cc"
           , "src/leveldown.cc"
           , "src/leveldown_async.cc"
+          , "src/snapshot.cc"
         ]
     }]
 }
@@ -0,0 +1,26 @@
+// Builds a new database from entries in key order, see `LevelDOWN.build()`
+function Builder (binding) {
+  this.binding = binding
+}
+
+
+Builder.prototype.write = function (entries, callback) {
+  if (typeof callback != 'function')
+    throw new Error('write() requires a callback argument')
+
+  if (!Array.isArray(entries))
+    return callback(new Error('write() requires an array of entries'))
+
+  this.binding.write(entries, callback)
+}
+
+
+Builder.prototype.finish = function (callback) {
+  if (typeof callback != 'function')
+    throw new Error('finish() requires a callback argument')
+
+  this.binding.finish(callback)
+}
+
+
+module.exports = Builder
@@ -2,9 +2,9 @@ const util                 = require('util')
     , AbstractChainedBatch = require('abstract-leveldown').AbstractChainedBatch
 
 
-function ChainedBatch (db) {
+function ChainedBatch (db, options) {
   AbstractChainedBatch.call(this, db)
-  this.binding = db.binding.batch()
+  this.binding = db.binding.batch(options)
 }
 
 
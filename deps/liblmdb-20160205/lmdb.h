@@ -237,6 +237,12 @@ typedef unsigned int	MDB_dbi;
 /** @brief Opaque structure for navigating through a database */
 typedef struct MDB_cursor MDB_cursor;
 
+/** @brief Opaque structure for a bottom-up build of a new environment.
+ *
+ * (Local addition for the node binding, not part of upstream LMDB.)
+ */
+typedef struct MDB_build MDB_build;
+
 /** @brief Generic structure used for passing keys and data in and out
  * of the database.
  *
@@ -1526,6 +1532,111 @@ int  mdb_cursor_del(MDB_cursor *cursor, unsigned int flags);
 	 */
 int  mdb_cursor_count(MDB_cursor *cursor, size_t *countp);
 
+	/** @brief Estimate the relative position of a cursor in its database.
+	 *
+	 * The position is computed from the page indices on the cursor's
+	 * stack, each level weighted by the fan-out of the pages above it, so
+	 * the cost is proportional to the depth of the tree. It is exact only
+	 * when every subtree holds the same number of entries.
+	 * (Local addition for the node binding, not part of upstream LMDB.)
+	 * @param[in] cursor A cursor handle returned by #mdb_cursor_open()
+	 * @param[out] fraction Address where the position, between 0.0 (before
+	 * the first entry) and 1.0 (past the last entry), will be stored
+	 * @param[out] leafp Optional address where the number of the leaf page
+	 * the cursor is on will be stored
+	 * @return A non-zero error value on failure and 0 on success. Some possible
+	 * errors are:
+	 * <ul>
+	 *	<li>EINVAL - cursor is not initialized, or an invalid parameter was specified.
+	 * </ul>
+	 */
+int  mdb_cursor_position(MDB_cursor *cursor, double *fraction, size_t *leafp);
+
+	/** @brief Check whether a cursor is on the record of a named database.
+	 *
+	 * Such records live in the main database and can't be deleted with
+	 * #mdb_cursor_del() (doing so fails the transaction).
+	 * (Local addition for the node binding, not part of upstream LMDB.)
+	 * @param[in] cursor A cursor handle returned by #mdb_cursor_open()
+	 * @return 1 if the cursor is on a named database record, 0 if not or
+	 * if the cursor isn't on an entry.
+	 */
+int  mdb_cursor_is_db(MDB_cursor *cursor);
+
+	/** @brief Get the bytes of pages taken up by the entry at a cursor.
+	 *
+	 * That is its node and the node's slot on the leaf page, plus the
+	 * whole of any overflow pages holding its data, so that it can be
+	 * weighed against the pages of a database as reported by #mdb_stat().
+	 * (Local addition for the node binding, not part of upstream LMDB.)
+	 * @param[in] cursor A cursor handle returned by #mdb_cursor_open()
+	 * @param[out] bytes Address where the size will be stored
+	 * @return A non-zero error value on failure and 0 on success. Some possible
+	 * errors are:
+	 * <ul>
+	 *	<li>EINVAL - cursor is not on an entry, or an invalid parameter was specified.
+	 * </ul>
+	 */
+int  mdb_cursor_footprint(MDB_cursor *cursor, size_t *bytes);
+
+	/** @brief Start building a new environment from sorted data.
+	 *
+	 * Rather than going through transactions, cursors and page splits,
+	 * the builder writes fully packed leaf pages straight to a fresh data
+	 * file as records arrive, builds the branch levels bottom-up as the
+	 * leaves fill, and writes the meta pages last, once everything else is
+	 * on disk. Only the main database is built, with the default
+	 * comparison. The file is not a valid environment until
+	 * #mdb_build_finish() succeeds.
+	 * (Local addition for the node binding, not part of upstream LMDB.)
+	 * @param[in] path The directory for the environment, as for
+	 * #mdb_env_open(). It must not already contain a data file.
+	 * @param[in] flags 0 or #MDB_NOSUBDIR
+	 * @param[in] mode The UNIX permissions to set on the created file.
+	 * @param[out] build Address where the new #MDB_build handle will be stored
+	 * @return A non-zero error value on failure and 0 on success. Some possible
+	 * errors are:
+	 * <ul>
+	 *	<li>EEXIST - the data file already exists.
+	 *	<li>ENOMEM - out of memory.
+	 * </ul>
+	 */
+int  mdb_build_open(const char *path, unsigned int flags, mdb_mode_t mode, MDB_build **build);
+
+	/** @brief Add a record to a build.
+	 *
+	 * Records must be added in strictly ascending key order.
+	 * @param[in] build A build handle returned by #mdb_build_open()
+	 * @param[in] key The key to store
+	 * @param[in] data The data to store
+	 * @return A non-zero error value on failure and 0 on success. Some possible
+	 * errors are:
+	 * <ul>
+	 *	<li>MDB_KEYEXIST - the key is not greater than the one before it.
+	 *	<li>MDB_BAD_VALSIZE - the key or data is too big, or the key is empty.
+	 *	<li>EIO - a write error occurred, the build can only be aborted.
+	 * </ul>
+	 */
+int  mdb_build_put(MDB_build *build, MDB_val *key, MDB_val *data);
+
+	/** @brief Complete a build and free its handle.
+	 *
+	 * Writes out the pages still in progress and then the meta pages,
+	 * syncing the file before and after. The handle is freed even if an
+	 * error is returned.
+	 * @param[in] build A build handle returned by #mdb_build_open()
+	 * @return A non-zero error value on failure and 0 on success.
+	 */
+int  mdb_build_finish(MDB_build *build);
+
+	/** @brief Abandon a build and free its handle.
+	 *
+	 * The partly written data file is left behind, for the caller to
+	 * remove.
+	 * @param[in] build A build handle returned by #mdb_build_open()
+	 */
+void mdb_build_abort(MDB_build *build);
+
 	/** @brief Compare two data items according to a particular database.
 	 *
 	 * This returns a comparison as if the two data items were keys in the
@@ -7483,6 +7483,451 @@ mdb_cursor_close(MDB_cursor *mc)
 	}
 }
 
+int
+mdb_cursor_position(MDB_cursor *mc, double *fraction, size_t *leafp)
+{
+	double		 pos = 0, width = 1;
+	unsigned int	 i, nkeys;
+
+	if (mc == NULL || fraction == NULL)
+		return EINVAL;
+
+	if (mc->mc_txn->mt_flags & MDB_TXN_BLOCKED)
+		return MDB_BAD_TXN;
+
+	if (!(mc->mc_flags & C_INITIALIZED) || !mc->mc_snum)
+		return EINVAL;
+
+	if (mc->mc_flags & C_EOF) {
+		pos = 1;
+	} else {
+		/* each level narrows the slice of the keyspace the cursor is in */
+		for (i = 0; i < mc->mc_snum; i++) {
+			nkeys = NUMKEYS(mc->mc_pg[i]);
+			if (!nkeys)
+				break;
+			width /= nkeys;
+			pos += width * mc->mc_ki[i];
+		}
+	}
+
+	*fraction = pos;
+	if (leafp)
+		*leafp = mc->mc_pg[mc->mc_top]->mp_pgno;
+	return MDB_SUCCESS;
+}
+
+int
+mdb_cursor_is_db(MDB_cursor *mc)
+{
+	MDB_page	*mp;
+	MDB_node	*leaf;
+
+	if (mc == NULL || !(mc->mc_flags & C_INITIALIZED) || !mc->mc_snum
+		|| (mc->mc_flags & C_EOF))
+		return 0;
+
+	mp = mc->mc_pg[mc->mc_top];
+	if (IS_LEAF2(mp) || mc->mc_ki[mc->mc_top] >= NUMKEYS(mp))
+		return 0;
+
+	leaf = NODEPTR(mp, mc->mc_ki[mc->mc_top]);
+	return (leaf->mn_flags & (F_DUPDATA|F_SUBDATA)) == F_SUBDATA;
+}
+
+int
+mdb_cursor_footprint(MDB_cursor *mc, size_t *bytes)
+{
+	MDB_page	*mp;
+	MDB_node	*leaf;
+	size_t		 sz;
+
+	if (mc == NULL || bytes == NULL)
+		return EINVAL;
+
+	if (mc->mc_txn->mt_flags & MDB_TXN_BLOCKED)
+		return MDB_BAD_TXN;
+
+	if (!(mc->mc_flags & C_INITIALIZED) || !mc->mc_snum
+		|| (mc->mc_flags & C_EOF))
+		return EINVAL;
+
+	mp = mc->mc_pg[mc->mc_top];
+	if (mc->mc_ki[mc->mc_top] >= NUMKEYS(mp))
+		return EINVAL;
+
+	if (IS_LEAF2(mp)) {
+		*bytes = mc->mc_db->md_pad;
+		return MDB_SUCCESS;
+	}
+
+	leaf = NODEPTR(mp, mc->mc_ki[mc->mc_top]);
+	sz = NODESIZE + NODEKSZ(leaf) + sizeof(indx_t);
+	if (F_ISSET(leaf->mn_flags, F_BIGDATA)) {
+		sz += sizeof(pgno_t);
+		sz += (size_t)OVPAGES(NODEDSZ(leaf), mc->mc_txn->mt_env->me_psize)
+			* mc->mc_txn->mt_env->me_psize;
+	} else {
+		sz += NODEDSZ(leaf);
+	}
+
+	*bytes = sz;
+	return MDB_SUCCESS;
+}
+
+/** @defgroup build	Bottom-up build
+ *	Writing a new environment from sorted records without transactions.
+ *	Pages are written strictly in page number order as they fill: a
+ *	record's overflow pages, if any, then each leaf page once the next
+ *	record doesn't fit, pushing a node for it into the branch page above
+ *	(which may fill and be pushed up in turn). The meta pages, at the
+ *	start of the file, are written last.
+ *	@{
+ */
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#define MDB_BUILD_SYNC(fp)	_commit(_fileno(fp))
+#else
+#define MDB_BUILD_SYNC(fp)	MDB_FDATASYNC(fileno(fp))
+#endif
+
+struct MDB_build {
+	FILE		*mb_fp;
+	unsigned int	 mb_psize;
+	unsigned int	 mb_nodemax;
+	unsigned int	 mb_maxkey;
+	unsigned int	 mb_depth;		/**< levels with a page in progress */
+	int		 mb_rc;			/**< set once the file is unusable */
+	pgno_t		 mb_next_pg;		/**< the next page to be written */
+	MDB_db		 mb_db;
+	MDB_page	*mb_pg[CURSOR_STACK];	/**< in progress, leaves at 0 */
+	MDB_val		 mb_first[CURSOR_STACK];	/**< first key of each mb_pg */
+	pgno_t		 mb_count[CURSOR_STACK];	/**< pages written per level */
+	MDB_val		 mb_last;		/**< the last key put */
+	char		*mb_keys;		/**< space for mb_first & mb_last */
+	char		*mb_zero;		/**< a page of zeroes */
+};
+
+static int
+mdb_build_write(MDB_build *b, const void *ptr, size_t size)
+{
+	if (size && fwrite(ptr, 1, size, b->mb_fp) != size)
+		return errno ? errno : EIO;
+	return MDB_SUCCESS;
+}
+
+static void
+mdb_build_reset(MDB_build *b, unsigned int level)
+{
+	MDB_page *mp = b->mb_pg[level];
+
+	memset(mp, 0, b->mb_psize);
+	mp->mp_flags = level ? P_BRANCH : P_LEAF;
+	mp->mp_lower = PAGEHDRSZ - PAGEBASE;
+	mp->mp_upper = b->mb_psize - PAGEBASE;
+	b->mb_first[level].mv_size = 0;
+}
+
+static int mdb_build_flush(MDB_build *b, unsigned int level);
+
+/** Add a node to the page in progress at \b level, writing the page
+ * out first if the node doesn't fit. Branch nodes point at \b pgno,
+ * as do leaf nodes with #F_BIGDATA.
+ */
+static int
+mdb_build_node(MDB_build *b, unsigned int level, MDB_val *key, MDB_val *data,
+	pgno_t pgno, unsigned int flags)
+{
+	MDB_page	*mp = b->mb_pg[level];
+	MDB_node	*node;
+	size_t		 ksize, node_size;
+	indx_t		 ofs;
+	int			 rc;
+
+	for (;;) {
+		/* the first key on a branch page is never looked at */
+		ksize = level && !NUMKEYS(mp) ? 0 : key->mv_size;
+		node_size = NODESIZE + ksize;
+		if (!level)
+			node_size += (flags & F_BIGDATA) ? sizeof(pgno_t) : data->mv_size;
+		node_size = EVEN(node_size);
+		if (node_size + sizeof(indx_t) <= SIZELEFT(mp))
+			break;
+		if ((rc = mdb_build_flush(b, level)) != MDB_SUCCESS)
+			return rc;
+	}
+
+	if (!NUMKEYS(mp)) {
+		memcpy(b->mb_first[level].mv_data, key->mv_data, key->mv_size);
+		b->mb_first[level].mv_size = key->mv_size;
+	}
+
+	ofs = mp->mp_upper - node_size;
+	mp->mp_ptrs[NUMKEYS(mp)] = ofs;
+	mp->mp_upper = ofs;
+	mp->mp_lower += sizeof(indx_t);
+
+	node = NODEPTR(mp, NUMKEYS(mp) - 1);
+	node->mn_ksize = ksize;
+	node->mn_flags = flags;
+	if (level)
+		SETPGNO(node, pgno);
+	else
+		SETDSZ(node, data->mv_size);
+	if (ksize)
+		memcpy(NODEKEY(node), key->mv_data, ksize);
+
+	if (!level) {
+		if (flags & F_BIGDATA)
+			memcpy(NODEDATA(node), &pgno, sizeof(pgno_t));
+		else if (data->mv_size)
+			memcpy(NODEDATA(node), data->mv_data, data->mv_size);
+	}
+
+	return MDB_SUCCESS;
+}
+
+/** Write out the page in progress at \b level, add a node for it to
+ * the level above and start a new one.
+ */
+static int
+mdb_build_flush(MDB_build *b, unsigned int level)
+{
+	MDB_page	*mp = b->mb_pg[level];
+	pgno_t		 pgno = b->mb_next_pg++;
+	int			 rc;
+
+	mp->mp_pgno = pgno;
+	if ((rc = mdb_build_write(b, mp, b->mb_psize)) != MDB_SUCCESS)
+		return rc;
+	b->mb_count[level]++;
+	if (level)
+		b->mb_db.md_branch_pages++;
+	else
+		b->mb_db.md_leaf_pages++;
+
+	if (level + 1 == b->mb_depth) {
+		if (b->mb_depth == CURSOR_STACK)
+			return MDB_CURSOR_FULL;
+		if ((b->mb_pg[b->mb_depth] = malloc(b->mb_psize)) == NULL)
+			return ENOMEM;
+		mdb_build_reset(b, b->mb_depth++);
+	}
+
+	rc = mdb_build_node(b, level + 1, &b->mb_first[level], NULL, pgno, 0);
+	mdb_build_reset(b, level);
+	return rc;
+}
+
+int ESECT
+mdb_build_open(const char *path, unsigned int flags, mdb_mode_t mode,
+	MDB_build **ret)
+{
+	MDB_build	*b;
+	char		*dpath;
+	int			 i, fd, rc;
+
+	if (path == NULL || ret == NULL || (flags & ~MDB_NOSUBDIR))
+		return EINVAL;
+
+	if ((b = calloc(1, sizeof(MDB_build))) == NULL)
+		return ENOMEM;
+
+	GET_PAGESIZE(b->mb_psize);
+	if (b->mb_psize > MAX_PAGESIZE)
+		b->mb_psize = MAX_PAGESIZE;
+	b->mb_nodemax = (((b->mb_psize - PAGEHDRSZ) / MDB_MINKEYS) & -2)
+		- sizeof(indx_t);
+#if MDB_MAXKEYSIZE
+	b->mb_maxkey = MDB_MAXKEYSIZE;
+#else
+	b->mb_maxkey = b->mb_nodemax - (NODESIZE + sizeof(MDB_db));
+#endif
+	b->mb_db.md_root = P_INVALID;
+	b->mb_depth = 1;
+
+	b->mb_keys = malloc((CURSOR_STACK + 1) * b->mb_maxkey);
+	b->mb_zero = calloc(NUM_METAS, b->mb_psize);
+	b->mb_pg[0] = malloc(b->mb_psize);
+	if (!b->mb_keys || !b->mb_zero || !b->mb_pg[0]) {
+		mdb_build_abort(b);
+		return ENOMEM;
+	}
+	for (i = 0; i < CURSOR_STACK; i++)
+		b->mb_first[i].mv_data = b->mb_keys + i * b->mb_maxkey;
+	b->mb_last.mv_data = b->mb_keys + CURSOR_STACK * b->mb_maxkey;
+	mdb_build_reset(b, 0);
+
+	if (flags & MDB_NOSUBDIR) {
+		dpath = (char *)path;
+	} else {
+		if ((dpath = malloc(strlen(path) + sizeof(DATANAME))) == NULL) {
+			mdb_build_abort(b);
+			return ENOMEM;
+		}
+		sprintf(dpath, "%s" DATANAME, path);
+	}
+
+#ifdef _WIN32
+	fd = _open(dpath, _O_WRONLY|_O_CREAT|_O_EXCL|_O_BINARY, mode);
+	b->mb_fp = fd == -1 ? NULL : _fdopen(fd, "wb");
+#else
+	fd = open(dpath, O_WRONLY|O_CREAT|O_EXCL, mode);
+	b->mb_fp = fd == -1 ? NULL : fdopen(fd, "wb");
+#endif
+	rc = errno;
+	if (dpath != path)
+		free(dpath);
+	if (b->mb_fp == NULL) {
+		if (fd != -1)
+			close(fd);
+		mdb_build_abort(b);
+		return rc;
+	}
+	setvbuf(b->mb_fp, NULL, _IOFBF, 1 << 20);
+
+	/* room for the meta pages, see mdb_build_finish() */
+	if ((rc = mdb_build_write(b, b->mb_zero, NUM_METAS * b->mb_psize))) {
+		mdb_build_abort(b);
+		return rc;
+	}
+	b->mb_next_pg = NUM_METAS;
+
+	*ret = b;
+	return MDB_SUCCESS;
+}
+
+int
+mdb_build_put(MDB_build *b, MDB_val *key, MDB_val *data)
+{
+	MDB_page	 hdr;
+	pgno_t		 pgno = 0, ovpages;
+	unsigned int flags = 0;
+	int			 rc;
+
+	if (b == NULL || key == NULL || data == NULL)
+		return EINVAL;
+	if (b->mb_rc)
+		return b->mb_rc;
+
+	if (key->mv_size - 1 >= b->mb_maxkey)
+		return MDB_BAD_VALSIZE;
+#if SIZE_MAX > MAXDATASIZE
+	if (data->mv_size > MAXDATASIZE)
+		return MDB_BAD_VALSIZE;
+#endif
+	if (b->mb_db.md_entries && mdb_cmp_memn(key, &b->mb_last) <= 0)
+		return MDB_KEYEXIST;
+
+	/* same test as mdb_node_add(), the data goes out ahead of its leaf */
+	if (NODESIZE + key->mv_size + data->mv_size > b->mb_nodemax) {
+		pgno = b->mb_next_pg;
+		ovpages = OVPAGES(data->mv_size, b->mb_psize);
+		memset(&hdr, 0, PAGEHDRSZ);
+		hdr.mp_pgno = pgno;
+		hdr.mp_flags = P_OVERFLOW;
+		hdr.mp_pages = ovpages;
+		if ((rc = mdb_build_write(b, &hdr, PAGEHDRSZ))
+			|| (rc = mdb_build_write(b, data->mv_data, data->mv_size))
+			|| (rc = mdb_build_write(b, b->mb_zero,
+				ovpages * b->mb_psize - PAGEHDRSZ - data->mv_size)))
+			return (b->mb_rc = rc);
+		b->mb_next_pg += ovpages;
+		b->mb_db.md_overflow_pages += ovpages;
+		flags = F_BIGDATA;
+	}
+
+	if ((rc = mdb_build_node(b, 0, key, data, pgno, flags)))
+		return (b->mb_rc = rc);
+
+	memcpy(b->mb_last.mv_data, key->mv_data, key->mv_size);
+	b->mb_last.mv_size = key->mv_size;
+	b->mb_db.md_entries++;
+	return MDB_SUCCESS;
+}
+
+int ESECT
+mdb_build_finish(MDB_build *b)
+{
+	MDB_page	*mp;
+	MDB_meta	*mm;
+	unsigned int i;
+	int			 rc;
+
+	if (b == NULL)
+		return EINVAL;
+	rc = b->mb_rc;
+
+	if (!rc && b->mb_db.md_entries) {
+		for (i = 0; ; i++) {
+			if (i + 1 == b->mb_depth && !b->mb_count[i]) {
+				/* the only page on the top level is the root */
+				mp = b->mb_pg[i];
+				mp->mp_pgno = b->mb_db.md_root = b->mb_next_pg++;
+				if (i)
+					b->mb_db.md_branch_pages++;
+				else
+					b->mb_db.md_leaf_pages++;
+				rc = mdb_build_write(b, mp, b->mb_psize);
+				break;
+			}
+			if ((rc = mdb_build_flush(b, i)))
+				break;
+		}
+		b->mb_db.md_depth = b->mb_depth;
+	}
+
+	if (!rc && (fflush(b->mb_fp) || MDB_BUILD_SYNC(b->mb_fp)))
+		rc = errno ? errno : EIO;
+
+	/* everything they point at is on disk, the file becomes valid */
+	if (!rc) {
+		for (i = 0; i < NUM_METAS; i++) {
+			mp = (MDB_page *)(b->mb_zero + i * b->mb_psize);
+			mp->mp_pgno = i;
+			mp->mp_flags = P_META;
+			mm = METADATA(mp);
+			mm->mm_magic = MDB_MAGIC;
+			mm->mm_version = MDB_DATA_VERSION;
+			mm->mm_mapsize = (size_t)b->mb_next_pg * b->mb_psize;
+			mm->mm_dbs[MAIN_DBI] = b->mb_db;
+			mm->mm_psize = b->mb_psize;
+			mm->mm_flags = MDB_INTEGERKEY; /* mm_dbs[FREE_DBI].md_flags */
+			mm->mm_dbs[FREE_DBI].md_root = P_INVALID;
+			mm->mm_last_pg = b->mb_next_pg - 1;
+			mm->mm_txnid = 1;
+		}
+		if (fseek(b->mb_fp, 0, SEEK_SET)
+			|| (rc = mdb_build_write(b, b->mb_zero, NUM_METAS * b->mb_psize))
+			|| fflush(b->mb_fp) || MDB_BUILD_SYNC(b->mb_fp))
+			rc = rc ? rc : (errno ? errno : EIO);
+	}
+
+	if (fclose(b->mb_fp) && !rc)
+		rc = errno ? errno : EIO;
+	b->mb_fp = NULL;
+	mdb_build_abort(b);
+	return rc;
+}
+
+void ESECT
+mdb_build_abort(MDB_build *b)
+{
+	unsigned int i;
+
+	if (b == NULL)
+		return;
+	if (b->mb_fp)
+		fclose(b->mb_fp);
+	for (i = 0; i < b->mb_depth; i++)
+		free(b->mb_pg[i]);
+	free(b->mb_keys);
+	free(b->mb_zero);
+	free(b);
+}
+/** @} */
+
 MDB_txn *
 mdb_cursor_txn(MDB_cursor *mc)
 {
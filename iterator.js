@@ -6,10 +6,15 @@ const util             = require('util')
 function Iterator (db, options) {
   AbstractIterator.call(this, db)
 
-  this.binding    = db.binding.iterator(options)
-  this.cache      = null
-  this.finished   = false
-  this.fastFuture = fastFuture()
+  this.binding       = db.binding.iterator(options)
+  this.keyAsBuffer   = !options || options.keyAsBuffer !== false
+  this.valueAsBuffer = !options || options.valueAsBuffer !== false
+  this.slab          = null
+  this.table         = 0
+  this.count         = 0
+  this.index         = 0
+  this.finished      = false
+  this.fastFuture    = fastFuture()
 }
 
 util.inherits(Iterator, AbstractIterator)
@@ -17,7 +22,7 @@ util.inherits(Iterator, AbstractIterator)
 Iterator.prototype.seek = function (key) {
   if (typeof key !== 'string')
     throw new Error('seek requires a string key')
-  this.cache = null
+  this.slab = null
   this.binding.seek(key)
 }
 
@@ -26,9 +31,10 @@ Iterator.prototype._next = function (callback) {
     , key
     , value
 
-  if (this.cache && this.cache.length) {
-    key   = this.cache.pop()
-    value = this.cache.pop()
+  if (this.slab && this.index < this.count) {
+    key   = this._slice(this.index * 2, this.keyAsBuffer)
+    value = this._slice(this.index * 2 + 1, this.valueAsBuffer)
+    this.index++
 
     this.fastFuture(function () {
       callback(null, key, value)
@@ -39,10 +45,10 @@ Iterator.prototype._next = function (callback) {
       callback()
     })
   } else {
-    this.binding.next(function (err, array, finished) {
+    this.binding.next(function (err, slab, finished) {
       if (err) return callback(err)
 
-      that.cache    = array
+      that._load(slab)
       that.finished = finished
       that._next(callback)
     })
@@ -52,8 +58,28 @@ Iterator.prototype._next = function (callback) {
 }
 
 
+// a batch arrives as one Buffer: the packed keys & values, then 2n+1
+// uint32le offsets delimiting them and finally the entry count n, see
+// SlabBatch in src/iterator.h
+Iterator.prototype._load = function (slab) {
+  this.count = slab.readUInt32LE(slab.length - 4)
+  this.table = slab.length - 4 - (this.count * 2 + 1) * 4
+  this.index = 0
+  this.slab  = slab
+}
+
+Iterator.prototype._slice = function (n, asBuffer) {
+  var start = this.slab.readUInt32LE(this.table + n * 4)
+    , end   = this.slab.readUInt32LE(this.table + n * 4 + 4)
+
+  return asBuffer
+    ? this.slab.slice(start, end)
+    : this.slab.toString('utf8', start, end)
+}
+
+
 Iterator.prototype._end = function (callback) {
-  delete this.cache
+  this.slab = null
   this.binding.end(callback)
 }
 
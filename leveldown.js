@@ -3,8 +3,12 @@ const util              = require('util')
 
     , binding           = require('bindings')('leveldown').leveldown
 
+    , Builder           = require('./builder')
     , ChainedBatch      = require('./chained-batch')
     , Iterator          = require('./iterator')
+    , packBatch         = require('./packed-batch')
+    , SubDB             = require('./subdb')
+    , ValueStream       = require('./value-stream')
 
 
 function LevelDOWN (location) {
@@ -19,6 +23,13 @@ util.inherits(LevelDOWN, AbstractLevelDOWN)
 
 
 LevelDOWN.prototype._open = function (options, callback) {
+  // zero-copy reads release their txn off-thread, which needs MDB_NOTLS,
+  // and aren't made into a writeMap, see get()
+  this._zeroCopy = !options.notls && !options.writeMap
+  // as do snapshots
+  this._snapshots = !options.notls
+  // a zero-copy read pins the map, which autoGrow then can't move
+  this._autoGrow = !!options.autoGrow
   this.binding.open(options, callback)
 }
 
@@ -33,11 +44,107 @@ LevelDOWN.prototype._put = function (key, value, options, callback) {
 }
 
 
+// the value as an array of Buffers or strings, put without joining them
+LevelDOWN.prototype.putParts = function (key, parts, options, callback) {
+  if (typeof options == 'function')
+    callback = options
+
+  if (typeof callback != 'function')
+    throw new Error('putParts() requires a callback argument')
+
+  var err = this._checkKey(key, 'key')
+  if (err)
+    return callback(err)
+
+  if (!Array.isArray(parts))
+    return callback(new Error('putParts() requires an array of parts'))
+
+  for (var i = 0; i < parts.length; i++) {
+    if (typeof parts[i] != 'string' && !Buffer.isBuffer(parts[i]))
+      return callback(new Error('putParts() requires each part to be a string or Buffer'))
+  }
+
+  if (typeof options != 'object' || options === null)
+    options = {}
+
+  this.binding.put(key, parts, options, callback)
+}
+
+
 LevelDOWN.prototype._get = function (key, options, callback) {
   this.binding.get(key, options, callback)
 }
 
 
+LevelDOWN.prototype.getRange = function (key, offset, length, options, callback) {
+  if (typeof options == 'function')
+    callback = options
+
+  if (typeof callback != 'function')
+    throw new Error('getRange() requires a callback argument')
+
+  var err = this._checkKey(key, 'key')
+  if (err)
+    return callback(err)
+
+  if (typeof offset != 'number' || offset < 0)
+    return callback(new Error('getRange() requires a non-negative offset'))
+
+  if (length != null && (typeof length != 'number' || length < 0))
+    return callback(new Error('getRange() requires a non-negative length'))
+
+  if (typeof options != 'object' || options === null)
+    options = {}
+
+  this.binding.getRange(key, offset, length, options, callback)
+}
+
+
+// lets go of a zeroCopy Buffer's read transaction without waiting on GC
+LevelDOWN.prototype.releaseBuffer = function (buffer) {
+  return this.binding.releaseBuffer(buffer)
+}
+
+
+LevelDOWN.prototype.createValueStream = function (key, options) {
+  return new ValueStream(this, key, options, this._valueStreamMode(options))
+}
+
+
+// how a ValueStream reads a value given no snapshot, see value-stream.js;
+// zero-copy only when asked for, its chunks pin the map until GC
+LevelDOWN.prototype._valueStreamMode = function (options) {
+  if (options && options.zeroCopy && this._zeroCopy && !this._autoGrow)
+    return 'pinned'
+  return this._snapshots ? 'snapshot' : 'copy'
+}
+
+
+LevelDOWN.prototype.getMany = function (keys, options, callback) {
+  if (typeof options == 'function')
+    callback = options
+
+  if (typeof callback != 'function')
+    throw new Error('getMany() requires a callback argument')
+
+  if (!Array.isArray(keys))
+    return callback(new Error('getMany() requires an array of keys'))
+
+  for (var i = 0; i < keys.length; i++) {
+    var err = this._checkKey(keys[i], 'key')
+    if (err)
+      return callback(err)
+  }
+
+  if (typeof options != 'object' || options === null)
+    options = {}
+
+  options.asBuffer = options.asBuffer !== false
+
+  this.binding.getMany(keys, options, callback)
+}
+
+
 LevelDOWN.prototype._del = function (key, options, callback) {
   this.binding.del(key, options, callback)
 }
@@ -48,6 +155,9 @@ LevelDOWN.prototype._chainedBatch = function () {
 }
 
 
+LevelDOWN.prototype.batch = packBatch.batch
+
+
 LevelDOWN.prototype._batch = function (operations, options, callback) {
   return this.binding.batch(operations, options, callback)
 }
@@ -58,6 +168,72 @@ LevelDOWN.prototype._approximateSize = function (start, end, callback) {
 }
 
 
+LevelDOWN.prototype.aggregate = function (options, callback) {
+  if (typeof callback != 'function')
+    throw new Error('aggregate() requires a callback argument')
+
+  if (typeof options != 'object' || options === null)
+    options = {}
+
+  this.binding.aggregate(options, callback)
+}
+
+
+LevelDOWN.prototype.clear = function (options, callback) {
+  if (typeof options == 'function') {
+    callback = options
+    options  = {}
+  }
+
+  if (typeof callback != 'function')
+    throw new Error('clear() requires a callback argument')
+
+  if (typeof options != 'object' || options === null)
+    options = {}
+
+  this.binding.clear(options, callback)
+}
+
+
+LevelDOWN.prototype.delRange = function (options, callback) {
+  if (typeof options == 'function') {
+    callback = options
+    options  = {}
+  }
+
+  if (typeof callback != 'function')
+    throw new Error('delRange() requires a callback argument')
+
+  if (typeof options != 'object' || options === null)
+    options = {}
+
+  this.binding.delRange(options, callback)
+}
+
+
+// with a `callback` the sub-db is opened on the threadpool, which never
+// has the main thread wait on the writer
+LevelDOWN.prototype.subdb = function (name, options, callback) {
+  if (typeof options == 'function') {
+    callback = options
+    options  = undefined
+  }
+
+  if (typeof name != 'string' || name.length === 0)
+    throw new Error('subdb() requires a name string argument')
+
+  if (typeof callback != 'function')
+    return new SubDB(this, name, options)
+
+  var self = this
+  this.binding.subdb(name, options, function (err, id) {
+    if (err)
+      return callback(err)
+    callback(null, new SubDB(self, name, options, id))
+  })
+}
+
+
 LevelDOWN.prototype.getProperty = function (property) {
   if (typeof property != 'string')
     throw new Error('getProperty() requires a valid `property` argument')
@@ -71,6 +247,12 @@ LevelDOWN.prototype._iterator = function (options) {
 }
 
 
+// one read txn for any number of reads to share, passed as `snapshot`
+LevelDOWN.prototype.snapshot = function () {
+  return this.binding.snapshot()
+}
+
+
 LevelDOWN.destroy = function (location, callback) {
   if (arguments.length < 2)
     throw new Error('destroy() requires `location` and `callback` arguments')
@@ -85,6 +267,17 @@ LevelDOWN.destroy = function (location, callback) {
 }
 
 
+LevelDOWN.packBatch = packBatch
+
+
+LevelDOWN.build = function (location, options) {
+  if (typeof location != 'string')
+    throw new Error('build() requires a location string argument')
+
+  return new Builder(binding.builder(location, options))
+}
+
+
 LevelDOWN.repair = function (location, callback) {
   if (arguments.length < 2)
     throw new Error('repair() requires `location` and `callback` arguments')
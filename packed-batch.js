@@ -0,0 +1,95 @@
+const AbstractLevelDOWN = require('abstract-leveldown').AbstractLevelDOWN
+
+    , PUT = 1
+    , DEL = 2
+
+
+function bytes (data) {
+  return Buffer.isBuffer(data) ? data : String(data)
+}
+
+
+function byteLength (data) {
+  return Buffer.isBuffer(data) ? data.length : Buffer.byteLength(data)
+}
+
+
+// Packs batch() operations into a single Buffer that the binding executes
+// straight from its bytes, rather than reading each op's properties from
+// V8 and holding them as objects of their own. Each op is a type byte (1
+// put, 2 del) then the key and, for a put, the value, each a UInt32LE
+// length and that many bytes
+function packBatch (operations) {
+  if (!Array.isArray(operations))
+    throw new Error('packBatch() requires an array of operations')
+
+  var size = 0
+    , data = []
+    , i, op
+
+  for (i = 0; i < operations.length; i++) {
+    op = operations[i]
+
+    if (op.type != 'put' && op.type != 'del')
+      throw new Error('packBatch() operations must have a type of \'put\' or \'del\'')
+    if (op.key === null || op.key === undefined)
+      throw new Error('key cannot be `null` or `undefined`')
+    if (op.subdb !== undefined)
+      throw new Error('packBatch() operations can\'t have a subdb, batch() into the subdb instead')
+
+    data.push(bytes(op.key))
+    size += 5 + byteLength(data[data.length - 1])
+
+    if (op.type == 'put') {
+      if (op.value === null || op.value === undefined)
+        throw new Error('value cannot be `null` or `undefined`')
+      data.push(bytes(op.value))
+      size += 4 + byteLength(data[data.length - 1])
+    }
+  }
+
+  var packed = new Buffer(size)
+    , offset = 0
+    , next   = 0
+
+  function write () {
+    var from   = data[next++]
+      , length = Buffer.isBuffer(from)
+          ? from.copy(packed, offset + 4)
+          : packed.write(from, offset + 4)
+
+    packed.writeUInt32LE(length, offset)
+    offset += 4 + length
+  }
+
+  for (i = 0; i < operations.length; i++) {
+    packed[offset++] = operations[i].type == 'put' ? PUT : DEL
+    write()
+    if (operations[i].type == 'put')
+      write()
+  }
+
+  return packed
+}
+
+
+// batch() for LevelDOWN & SubDB, taking a Buffer from packBatch() as well
+// as an array, which abstract-leveldown would reject
+packBatch.batch = function (operations, options, callback) {
+  if (!Buffer.isBuffer(operations))
+    return AbstractLevelDOWN.prototype.batch.apply(this, arguments)
+
+  if (typeof options == 'function')
+    callback = options
+
+  if (typeof callback != 'function')
+    throw new Error('batch(array) requires a callback argument')
+
+  if (typeof options != 'object' || options === null)
+    options = {}
+
+  this._batch(operations, options, callback)
+}
+
+
+module.exports = packBatch
@@ -0,0 +1,69 @@
+/* Copyright (c) 2012-2016 LevelDOWN contributors
+ * See list at <https://github.com/level/leveldown#contributing>
+ * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
+ */
+
+#ifndef LD_ARENA_H
+#define LD_ARENA_H
+
+#include <stddef.h>
+#include <string.h>
+
+namespace leveldown {
+
+#define ARENA_MIN_CAPACITY 4096
+
+/*
+ * Bytes copied in back to back in a single block, freed all at once by
+ * Reset(), which keeps the block for reuse. The block moves as it grows
+ * so what's in it is addressed by offset, see At().
+ */
+class Arena {
+public:
+  Arena () : data(NULL), size(0), capacity(0) {}
+  ~Arena () { delete[] data; }
+
+  // room for `n` more bytes, at the offset returned
+  size_t Alloc (size_t n) {
+    if (size + n > capacity)
+      Grow(size + n);
+    size_t at = size;
+    size += n;
+    return at;
+  }
+
+  size_t Copy (const void* from, size_t n) {
+    size_t at = Alloc(n);
+    if (n > 0)
+      memcpy(data + at, from, n);
+    return at;
+  }
+
+  char* At (size_t offset) const { return data + offset; }
+  size_t Capacity () const { return capacity; }
+  void Reset () { size = 0; }
+
+private:
+  char* data;
+  size_t size;
+  size_t capacity;
+
+  void Grow (size_t needed) {
+    size_t grown = capacity < ARENA_MIN_CAPACITY
+      ? ARENA_MIN_CAPACITY
+      : capacity * 2;
+    if (grown < needed)
+      grown = needed;
+
+    char* moved = new char[grown];
+    if (size > 0)
+      memcpy(moved, data, size);
+    delete[] data;
+    data = moved;
+    capacity = grown;
+  }
+};
+
+} // namespace leveldown
+
+#endif
@@ -2,6 +2,9 @@
 #include <node_buffer.h>
 #include <nan.h>
 
+#include <errno.h>
+#include <string>
+
 #include "database.h"
 #include "batch_async.h"
 #include "batch.h"
@@ -11,105 +14,473 @@ namespace leveldown {
 
 static Nan::Persistent<v8::FunctionTemplate> batch_constructor;
 
-BatchOp::BatchOp (v8::Local<v8::Object> &keyHandle, MDB_val key) : key(key) {
-  Nan::HandleScope scope;
+// arenas of batches gone, kept for the next batches; only ever touched
+// from the main thread
+static std::vector< Arena* > arenaPool;
+
+static Arena* AcquireArena () {
+  if (arenaPool.empty())
+    return new Arena();
 
-  v8::Local<v8::Object> obj = Nan::New<v8::Object>();
-  obj->Set(Nan::New("key").ToLocalChecked(), keyHandle);
-  persistentHandle.Reset(obj);
+  Arena* arena = arenaPool.back();
+  arenaPool.pop_back();
+  return arena;
 }
 
-BatchOp::~BatchOp () {
-  Nan::HandleScope scope;
+static void ReleaseArena (Arena* arena) {
+  if (arenaPool.size() >= ARENA_POOL_MAX
+      || arena->Capacity() > ARENA_POOL_CAPACITY_MAX) {
+    delete arena;
+    return;
+  }
 
-  v8::Local<v8::Object> handle = Nan::New<v8::Object>(persistentHandle);
-  v8::Local<v8::Object> keyHandle =
-      handle->Get(Nan::New("key").ToLocalChecked()).As<v8::Object>();
-  DisposeStringOrBufferFromSlice(keyHandle, key);
+  arena->Reset();
+  arenaPool.push_back(arena);
+}
 
-  if (!persistentHandle.IsEmpty())
-    persistentHandle.Reset();
+static inline uint32_t ReadUInt32LE (const char* from) {
+  const unsigned char* p = (const unsigned char*)from;
+  return (uint32_t)p[0]
+    | ((uint32_t)p[1] << 8)
+    | ((uint32_t)p[2] << 16)
+    | ((uint32_t)p[3] << 24);
 }
 
-BatchDel::BatchDel (v8::Local<v8::Object> &keyHandle, MDB_val key)
-  : BatchOp(keyHandle, key) {}
+/*
+ * A packed op is a type byte, then the key & (for a put) the value, each
+ * a UInt32LE length followed by that many bytes. Returns where the next op
+ * starts, or NULL if the op is unknown or runs past `end`.
+ */
+const char* ReadPackedOp (const char* from, const char* end, PackedOp& op) {
+  if (end - from < 5)
+    return NULL;
+
+  op.type = (uint8_t)*from++;
+  if (op.type != PACKED_PUT && op.type != PACKED_DEL)
+    return NULL;
+
+  op.key.mv_size = ReadUInt32LE(from);
+  from += 4;
+  if ((size_t)(end - from) < op.key.mv_size)
+    return NULL;
+  op.key.mv_data = (void*)from;
+  from += op.key.mv_size;
+
+  if (op.type == PACKED_DEL) {
+    op.value.mv_size = 0;
+    op.value.mv_data = NULL;
+    return from;
+  }
 
-BatchDel::~BatchDel () {}
+  if (end - from < 4)
+    return NULL;
+  op.value.mv_size = ReadUInt32LE(from);
+  from += 4;
+  if ((size_t)(end - from) < op.value.mv_size)
+    return NULL;
+  op.value.mv_data = (void*)from;
 
-int BatchDel::Execute (MDB_txn *txn, MDB_dbi dbi) {
-  return mdb_del(txn, dbi, &key, NULL);
+  return from + op.value.mv_size;
 }
 
-BatchPut::BatchPut (
-    v8::Local<v8::Object> &keyHandle
-  , MDB_val key
-  , v8::Local<v8::Object> &valueHandle
-  , MDB_val value
-) : BatchOp(keyHandle, key)
-  , value(value)
-{
-  Nan::HandleScope scope;
-  v8::Local<v8::Object> handle = Nan::New<v8::Object>(persistentHandle);
-  handle->Set(Nan::New("value").ToLocalChecked(), valueHandle);
+int BatchOp::Execute (
+      MDB_txn *txn
+    , const Arena& arena
+    , const std::vector< BatchPart >& parts
+    , bool& applied) const {
+  int rc;
+  MDB_val k;
+  k.mv_data = arena.At(key);
+  k.mv_size = keySize;
+
+  applied = false;
+  if (condition == WRITE_IF_EQUALS) {
+    MDB_val e;
+    e.mv_data = arena.At(expected);
+    e.mv_size = expectedSize;
+    rc = ValueEquals(txn, dbi, &k, e, applied);
+    if (rc != 0 || !applied)
+      return rc;
+  }
+
+  if (type == DEL) {
+    rc = mdb_del(txn, dbi, &k, NULL);
+    applied = rc == 0;
+    return rc;
+  }
+
+  unsigned int putFlags = flags
+    | (condition == WRITE_IF_ABSENT ? MDB_NOOVERWRITE : 0);
+
+  if (partCount > 0) {
+    std::vector< MDB_val > scatter(partCount);
+    for (size_t i = 0; i < partCount; i++) {
+      const BatchPart& part = parts[firstPart + i];
+      scatter[i].mv_data = part.data != NULL
+        ? (void*)part.data
+        : (void*)arena.At(part.at);
+      scatter[i].mv_size = part.size;
+    }
+    rc = PutParts(txn, dbi, &k, scatter, valueSize, putFlags);
+  } else {
+    MDB_val v;
+    v.mv_data = arena.At(value);
+    v.mv_size = valueSize;
+
+    if (type != PUT)
+      return Merge(txn, &k, &v, applied);
+    rc = mdb_put(txn, dbi, &k, &v, putFlags);
+  }
+
+  if (rc == MDB_KEYEXIST && condition == WRITE_IF_ABSENT)
+    return 0;
+  applied = rc == 0;
+
+  return rc;
 }
 
-BatchPut::~BatchPut () {
-  Nan::HandleScope scope;
+static inline int64_t ReadInt64LE (const void* from) {
+  const unsigned char* p = (const unsigned char*)from;
+  uint64_t n = 0;
+  for (int i = 7; i >= 0; i--)
+    n = (n << 8) | p[i];
+  return (int64_t)n;
+}
 
-  v8::Local<v8::Object> handle = Nan::New<v8::Object>(persistentHandle);
-  v8::Local<v8::Object> valueHandle =
-      handle->Get(Nan::New("value").ToLocalChecked()).As<v8::Object>();
+static inline void WriteInt64LE (int64_t n, void* to) {
+  unsigned char* p = (unsigned char*)to;
+  for (int i = 0; i < 8; i++, n >>= 8)
+    p[i] = (unsigned char)(n & 0xff);
+}
 
-  DisposeStringOrBufferFromSlice(valueHandle, value);
+// as memcmp() over the common length, then the shorter first
+static inline int CompareBytes (const MDB_val& a, const MDB_val& b) {
+  size_t length = a.mv_size < b.mv_size ? a.mv_size : b.mv_size;
+  int diff = length > 0 ? memcmp(a.mv_data, b.mv_data, length) : 0;
+  if (diff != 0)
+    return diff;
+  return a.mv_size < b.mv_size ? -1 : a.mv_size > b.mv_size ? 1 : 0;
 }
 
-int BatchPut::Execute (MDB_txn *txn, MDB_dbi dbi) {
-  return mdb_put(txn, dbi, &key, &value, 0);
+/*
+ * Read-modify-write of the current value, all in the write txn. A missing
+ * key merges as if it were `v` alone (ADD as if it were 0). The merged
+ * value is built apart from the page the current one lives in, which
+ * mdb_put() may rewrite under it.
+ */
+int BatchOp::Merge (MDB_txn *txn, MDB_val* k, MDB_val* v, bool& applied) const {
+  MDB_val current;
+  MDB_val merged;
+  std::string scratch;
+
+  int rc = mdb_get(txn, dbi, k, &current);
+  if (rc != 0 && rc != MDB_NOTFOUND)
+    return rc;
+  bool missing = rc == MDB_NOTFOUND;
+
+  applied = false;
+  if ((type == ADD || numeric) && (v->mv_size != 8
+      || (!missing && current.mv_size != 8)))
+    return MDB_BAD_VALSIZE;
+
+  switch (type) {
+  case ADD:
+    scratch.resize(8);
+    WriteInt64LE(
+        (int64_t)((uint64_t)(missing ? 0 : ReadInt64LE(current.mv_data))
+          + (uint64_t)ReadInt64LE(v->mv_data))
+      , &scratch[0]
+    );
+    break;
+  case APPEND:
+    if (missing)
+      break;
+    scratch.reserve(current.mv_size + v->mv_size);
+    scratch.append((const char*)current.mv_data, current.mv_size);
+    scratch.append((const char*)v->mv_data, v->mv_size);
+    break;
+  case MAX:
+  case MIN:
+    if (!missing) {
+      int diff = numeric
+        ? (ReadInt64LE(v->mv_data) < ReadInt64LE(current.mv_data) ? -1
+          : ReadInt64LE(v->mv_data) > ReadInt64LE(current.mv_data) ? 1 : 0)
+        : CompareBytes(*v, current);
+      // the current value stands, nothing to write
+      if (type == MAX ? diff <= 0 : diff >= 0)
+        return 0;
+    }
+    break;
+  case BITOR:
+    if (missing)
+      break;
+    scratch.assign(
+        (const char*)current.mv_data
+      , current.mv_size
+    );
+    if (scratch.size() < v->mv_size)
+      scratch.resize(v->mv_size, 0);
+    for (size_t i = 0; i < v->mv_size; i++)
+      scratch[i] |= ((const char*)v->mv_data)[i];
+    break;
+  default:
+    return EINVAL;
+  }
+
+  if (scratch.empty() && type != ADD) {
+    merged = *v;
+  } else {
+    merged.mv_data = &scratch[0];
+    merged.mv_size = scratch.size();
+  }
+
+  rc = mdb_put(txn, dbi, k, &merged, 0);
+  applied = rc == 0;
+
+  return rc;
 }
 
-WriteBatch::WriteBatch (leveldown::Database* database, bool sync) : database(database) {
-  operations = new std::vector<BatchOp*>;
+WriteBatch::WriteBatch (
+    leveldown::Database* database
+  , bool sync
+  , MDB_dbi dbi
+  , bool append
+  , size_t commitBytes
+) : arena(AcquireArena())
+  , database(database)
+  , sync(sync)
+  , bytes(0)
+  , dbi(dbi)
+  , append(append)
+  , commitBytes(commitBytes)
+  , conditional(false) {
   written = false;
 }
 
 WriteBatch::~WriteBatch () {
-  Clear();
-  delete operations;
+  partBuffers.Reset();
+  ReleaseArena(arena);
 }
 
-void WriteBatch::Put (
-      v8::Local<v8::Object> &keyHandle
-    , MDB_val key
-    , v8::Local<v8::Object> &valueHandle
-    , MDB_val value) {
-  operations->push_back(new BatchPut(keyHandle, key, valueHandle, value));
-}
+/*
+ * Copies a key or value into the arena: a String's UTF-8 is written there
+ * directly, an Array's parts (see putParts()) back to back, as a merge
+ * needs its value whole; a put's parts go to CopyParts() instead. As with
+ * LD_STRING_OR_BUFFER_TO_SLICE(), `null`, `undefined` & empty are a single
+ * zero byte.
+ */
+size_t WriteBatch::CopyToArena (v8::Local<v8::Value> from, size_t& size) {
+  size_t at;
+
+  if (from->IsArray()) {
+    v8::Local<v8::Array> parts = from.As<v8::Array>();
+    at = arena->Alloc(0);
+    size = 0;
+    for (uint32_t i = 0; i < parts->Length(); i++) {
+      v8::Local<v8::Value> part = parts->Get(i);
+      if (node::Buffer::HasInstance(part)) {
+        arena->Copy(node::Buffer::Data(part), node::Buffer::Length(part));
+        size += node::Buffer::Length(part);
+      } else {
+        v8::Local<v8::String> str = part->ToString();
+        size_t length = str->Utf8Length();
+        str->WriteUtf8(
+            arena->At(arena->Alloc(length))
+          , -1
+          , NULL
+          , v8::String::NO_NULL_TERMINATION
+        );
+        size += length;
+      }
+    }
+    return at;
+  }
+
+  if (!from->IsNull() && !from->IsUndefined()) {
+    if (node::Buffer::HasInstance(from)) {
+      size = node::Buffer::Length(from);
+      if (size > 0)
+        return arena->Copy(node::Buffer::Data(from), size);
+    } else {
+      v8::Local<v8::String> str = from->ToString();
+      size = str->Utf8Length();
+      if (size > 0) {
+        at = arena->Alloc(size);
+        str->WriteUtf8(
+            arena->At(at)
+          , -1
+          , NULL
+          , v8::String::NO_NULL_TERMINATION
+        );
+        return at;
+      }
+    }
+  }
 
-void WriteBatch::Delete (v8::Local<v8::Object> &keyHandle, MDB_val key) {
-  operations->push_back(new BatchDel(keyHandle, key));
+  size = 1;
+  at = arena->Alloc(1);
+  *arena->At(at) = 0;
+  return at;
 }
 
-void WriteBatch::Clear () {
-  for (std::vector< BatchOp* >::iterator it = operations->begin()
-    ; it != operations->end()
-    ; ) {
-    delete *it;
-    it = operations->erase(it);
+/*
+ * The parts of a put()'s Array value, as for putParts(): a Buffer part is
+ * pointed at & held in `partBuffers` rather than copied, so the value is
+ * only copied the once, by PutParts(). A String part is copied to the
+ * arena. Returns the index of the first part in `parts`.
+ */
+size_t WriteBatch::CopyParts (v8::Local<v8::Array> array, size_t& size) {
+  size_t first = parts.size();
+
+  if (partBuffers.IsEmpty())
+    partBuffers.Reset(Nan::New<v8::Array>());
+  v8::Local<v8::Array> buffers = Nan::New(partBuffers);
+
+  size = 0;
+  for (uint32_t i = 0; i < array->Length(); i++) {
+    v8::Local<v8::Value> from = array->Get(i);
+    BatchPart part;
+
+    if (node::Buffer::HasInstance(from)) {
+      part.data = node::Buffer::Data(from);
+      part.at = 0;
+      part.size = node::Buffer::Length(from);
+      buffers->Set(buffers->Length(), from);
+    } else {
+      v8::Local<v8::String> str = from->ToString();
+      part.data = NULL;
+      part.size = str->Utf8Length();
+      part.at = arena->Alloc(part.size);
+      str->WriteUtf8(
+          arena->At(part.at)
+        , -1
+        , NULL
+        , v8::String::NO_NULL_TERMINATION
+      );
+    }
+
+    parts.push_back(part);
+    size += part.size;
   }
-}
 
-void WriteBatch::Write (v8::Local<v8::Function> callback) {
-  Nan::HandleScope scope;
+  return first;
+}
 
-  written = true;
+void WriteBatch::Put (
+      v8::Local<v8::Value> keyHandle
+    , v8::Local<v8::Value> valueHandle
+    , MDB_dbi dbi
+    , WriteCondition condition
+    , v8::Local<v8::Value> expectedHandle) {
+  size_t keySize, valueSize, expectedSize = 0;
+  size_t key = CopyToArena(keyHandle, keySize);
+  size_t value = 0;
+  size_t firstPart = 0;
+  size_t partCount = valueHandle->IsArray()
+    ? valueHandle.As<v8::Array>()->Length()
+    : 0;
+  if (partCount > 0)
+    firstPart = CopyParts(valueHandle.As<v8::Array>(), valueSize);
+  else
+    value = CopyToArena(valueHandle, valueSize);
+  size_t expected = condition == WRITE_IF_EQUALS
+    ? CopyToArena(expectedHandle, expectedSize)
+    : 0;
+
+  BatchOp op(
+      BatchOp::PUT
+    , dbi
+    , append ? MDB_APPEND : 0
+    , key
+    , keySize
+    , value
+    , valueSize
+    , condition
+    , expected
+    , expectedSize
+  );
+  op.firstPart = firstPart;
+  op.partCount = partCount;
+  operations.push_back(op);
+  bytes += keySize + valueSize;
+  conditional = conditional || condition != WRITE_ALWAYS;
+}
 
-  if (operations->size() > 0) {
-    BatchWriteWorker* worker = new BatchWriteWorker(
-      this, new Nan::Callback(callback));
-    Nan::AsyncQueueWorker(worker);
+/*
+ * A merge op, see BatchOp::Merge(); a Number `value` is an Int64LE, for
+ * ADD and to make MAX & MIN compare numerically.
+ */
+void WriteBatch::Merge (
+      BatchOp::Type type
+    , v8::Local<v8::Value> keyHandle
+    , v8::Local<v8::Value> valueHandle
+    , MDB_dbi dbi) {
+  size_t keySize, valueSize;
+  size_t key = CopyToArena(keyHandle, keySize);
+  size_t value;
+
+  if (valueHandle->IsNumber()) {
+    valueSize = 8;
+    value = arena->Alloc(valueSize);
+    WriteInt64LE((int64_t)valueHandle->NumberValue(), arena->At(value));
   } else {
-    LD_RUN_CALLBACK(callback, 0, NULL);
+    value = CopyToArena(valueHandle, valueSize);
   }
+
+  BatchOp op(
+      type
+    , dbi
+    , 0
+    , key
+    , keySize
+    , value
+    , valueSize
+    , WRITE_ALWAYS
+    , 0
+    , 0
+  );
+  op.numeric = valueHandle->IsNumber()
+    && (type == BatchOp::MAX || type == BatchOp::MIN);
+  operations.push_back(op);
+  bytes += keySize + valueSize;
+}
+
+void WriteBatch::Delete (
+      v8::Local<v8::Value> keyHandle
+    , MDB_dbi dbi
+    , WriteCondition condition
+    , v8::Local<v8::Value> expectedHandle) {
+  size_t keySize, expectedSize = 0;
+  size_t key = CopyToArena(keyHandle, keySize);
+  size_t expected = condition == WRITE_IF_EQUALS
+    ? CopyToArena(expectedHandle, expectedSize)
+    : 0;
+
+  operations.push_back(BatchOp(
+      BatchOp::DEL
+    , dbi
+    , 0
+    , key
+    , keySize
+    , 0
+    , 0
+    , condition
+    , expected
+    , expectedSize
+  ));
+  bytes += keySize;
+  conditional = conditional || condition != WRITE_ALWAYS;
+}
+
+// the ops hold nothing of their own, all of it goes with the arena & the
+// part Buffers
+void WriteBatch::Clear () {
+  operations.clear();
+  parts.clear();
+  partBuffers.Reset();
+  arena->Reset();
+  bytes = 0;
+  conditional = false;
 }
 
 void WriteBatch::Init () {
@@ -131,9 +502,19 @@ NAN_METHOD(WriteBatch::New) {
     optionsObj = v8::Local<v8::Object>::Cast(info[1]);
   }
 
-  bool sync = BooleanOptionValue(optionsObj, "sync");
+  MDB_dbi dbi;
+  if (!database->ResolveDbi(SubDbOptionValue(optionsObj), database->dbi, dbi))
+    return Nan::ThrowError("sub-database has been dropped");
 
-  WriteBatch* batch = new WriteBatch(database, sync);
+  bool sync = BooleanOptionValue(optionsObj, "sync");
+  bool append = BooleanOptionValue(optionsObj, "append");
+  size_t commitBytes = UInt64OptionValue(
+      optionsObj
+    , "commitBytes"
+    , append ? DEFAULT_APPEND_COMMIT_BYTES : 0
+  );
+
+  WriteBatch* batch = new WriteBatch(database, sync, dbi, append, commitBytes);
   batch->Wrap(info.This());
 
   info.GetReturnValue().Set(info.This());
@@ -180,12 +561,7 @@ NAN_METHOD(WriteBatch::Put) {
   LD_CB_ERR_IF_NULL_OR_UNDEFINED(info[0], key)
   LD_CB_ERR_IF_NULL_OR_UNDEFINED(info[1], value)
 
-  v8::Local<v8::Object> keyBuffer = info[0].As<v8::Object>();
-  v8::Local<v8::Object> valueBuffer = info[1].As<v8::Object>();
-  LD_STRING_OR_BUFFER_TO_SLICE(key, keyBuffer, key)
-  LD_STRING_OR_BUFFER_TO_SLICE(value, valueBuffer, value)
-
-  batch->Put(keyBuffer, key, valueBuffer, value);
+  batch->Put(info[0], info[1], batch->dbi);
 
   info.GetReturnValue().Set(info.Holder());
 }
@@ -197,10 +573,7 @@ NAN_METHOD(WriteBatch::Del) {
 
   LD_CB_ERR_IF_NULL_OR_UNDEFINED(info[0], key)
 
-  v8::Local<v8::Object> keyBuffer = info[0].As<v8::Object>();
-  LD_STRING_OR_BUFFER_TO_SLICE(key, keyBuffer, key)
-
-  batch->Delete(keyBuffer, key);
+  batch->Delete(info[0], batch->dbi);
 
   info.GetReturnValue().Set(info.Holder());
 }
@@ -228,16 +601,21 @@ NAN_METHOD(WriteBatch::Write) {
     return Nan::ThrowError("write() already called on this batch");
   }
 
+  if (!batch->database->IsWritable()) {
+    v8::Local<v8::Function> callback = info[0].As<v8::Function>();
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "database is not open")
+  }
+
   batch->written = true;
 
-  if (batch->operations->size() > 0) {
+  if (batch->operations.size() > 0) {
     Nan::Callback *callback =
         new Nan::Callback(v8::Local<v8::Function>::Cast(info[0]));
-    BatchWriteWorker* worker = new BatchWriteWorker(batch, callback);
+    BatchWriteWorker* worker = new BatchWriteWorker(batch, callback, false);
     // persist to prevent accidental GC
     v8::Local<v8::Object> _this = info.This();
     worker->SaveToPersistent("batch", _this);
-    Nan::AsyncQueueWorker(worker);
+    batch->database->QueueWrite(worker);
   } else {
     LD_RUN_CALLBACK(v8::Local<v8::Function>::Cast(info[0]), 0, NULL);
   }
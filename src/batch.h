@@ -4,31 +4,95 @@
 #include <vector>
 #include <node.h>
 
+#include "arena.h"
 #include "database.h"
 
 namespace leveldown {
 
-class BatchDel : public BatchOp {
- public:
-  BatchDel (v8::Local<v8::Object> &keyHandle, MDB_val key);
-  virtual ~BatchDel ();
-  virtual int Execute (MDB_txn *txn, MDB_dbi dbi);
+// op codes of a packed batch, see packed-batch.js
+#define PACKED_PUT 1
+#define PACKED_DEL 2
+
+// one op of a packed batch, pointing into its Buffer
+struct PackedOp {
+  uint8_t type;
+  MDB_val key;
+  MDB_val value;
+};
+
+const char* ReadPackedOp (const char* from, const char* end, PackedOp& op);
+
+// one part of a put()'s Array value, either a Buffer's bytes pointed at
+// or, with `data` NULL, a String's copied into the Arena at `at`
+struct BatchPart {
+  const char* data;
+  size_t at;
+  size_t size;
 };
 
-class BatchPut : public BatchOp {
+// one op of a WriteBatch, its key & value copied into the batch's Arena
+class BatchOp {
 public:
-  BatchPut (
-      v8::Local<v8::Object> &keyHandle
-    , MDB_val key
-    , v8::Local<v8::Object> &valueHandle
-    , MDB_val value
-  );
+  // ADD onwards merge `value` into the current value, see Merge()
+  enum Type { PUT, DEL, ADD, APPEND, MAX, MIN, BITOR };
 
-  virtual ~BatchPut ();
-  virtual int Execute (MDB_txn *txn, MDB_dbi dbi);
+  BatchOp (
+      Type type
+    , MDB_dbi dbi
+    , unsigned int flags
+    , size_t key
+    , size_t keySize
+    , size_t value
+    , size_t valueSize
+    , WriteCondition condition
+    , size_t expected
+    , size_t expectedSize
+  ) : type(type)
+    , dbi(dbi)
+    , flags(flags)
+    , key(key)
+    , keySize(keySize)
+    , value(value)
+    , valueSize(valueSize)
+    , condition(condition)
+    , expected(expected)
+    , expectedSize(expectedSize) {
+    numeric = false;
+    firstPart = 0;
+    partCount = 0;
+  }
 
-protected:
-  MDB_val value;
+  // `applied` is set to whether the op's condition held & it went ahead
+  int Execute (
+      MDB_txn *txn
+    , const Arena& arena
+    , const std::vector< BatchPart >& parts
+    , bool& applied
+  ) const;
+  // approximate bytes written by Execute()
+  size_t Bytes () const { return keySize + valueSize; }
+
+  // MAX & MIN compare as Int64LE rather than bytes
+  bool numeric;
+  // a put of an Array value, its parts in WriteBatch::parts rather than
+  // joined in the Arena, see PutParts()
+  size_t firstPart;
+  size_t partCount;
+
+private:
+  int Merge (MDB_txn *txn, MDB_val* k, MDB_val* v, bool& applied) const;
+
+  Type type;
+  MDB_dbi dbi;
+  unsigned int flags;
+  // offsets into the Arena
+  size_t key;
+  size_t keySize;
+  size_t value;
+  size_t valueSize;
+  WriteCondition condition;
+  size_t expected;
+  size_t expectedSize;
 };
 
 class WriteBatch : public Nan::ObjectWrap {
@@ -39,24 +103,60 @@ public:
     , v8::Local<v8::Object> optionsObj
   );
 
-  WriteBatch  (Database* database, bool sync);
+  WriteBatch  (
+      Database* database
+    , bool sync
+    , MDB_dbi dbi
+    , bool append
+    , size_t commitBytes
+  );
   ~WriteBatch ();
 
   void Put    (
-      v8::Local<v8::Object> &keyHandle
-    , MDB_val key
-    , v8::Local<v8::Object> &valueHandle
-    , MDB_val value
+      v8::Local<v8::Value> keyHandle
+    , v8::Local<v8::Value> valueHandle
+    , MDB_dbi dbi
+    , WriteCondition condition = WRITE_ALWAYS
+    , v8::Local<v8::Value> expectedHandle = v8::Local<v8::Value>()
+  );
+  void Merge  (
+      BatchOp::Type type
+    , v8::Local<v8::Value> keyHandle
+    , v8::Local<v8::Value> valueHandle
+    , MDB_dbi dbi
+  );
+  void Delete (
+      v8::Local<v8::Value> keyHandle
+    , MDB_dbi dbi
+    , WriteCondition condition = WRITE_ALWAYS
+    , v8::Local<v8::Value> expectedHandle = v8::Local<v8::Value>()
   );
-  void Delete (v8::Local<v8::Object> &keyHandle, MDB_val key);
   void Clear  ();
-  void Write  (v8::Local<v8::Function> callback);
 
-  std::vector< BatchOp* >* operations;
+  std::vector< BatchOp > operations;
+  // the bytes of every key & value in `operations`
+  Arena* arena;
+  // the parts of puts with an Array value, see BatchOp::firstPart
+  std::vector< BatchPart > parts;
   Database* database;
+  bool sync;
+  size_t bytes;
+  // where put()/del() on a chained batch go
+  MDB_dbi dbi;
+  // puts are MDB_APPEND, keys must come in order and after any existing
+  bool append;
+  // commit whenever this much has been written, 0 for a single txn
+  size_t commitBytes;
+  // some op has a condition, write() reports which ops went ahead
+  bool conditional;
 
 private:
   bool written;
+  // the Buffers `parts` point into, held until the batch is gone
+  Nan::Persistent<v8::Array> partBuffers;
+
+  size_t CopyToArena (v8::Local<v8::Value> from, size_t& size);
+  size_t CopyParts (v8::Local<v8::Array> array, size_t& size);
 
   static NAN_METHOD(New);
   static NAN_METHOD(Put);
@@ -4,6 +4,9 @@
  */
 
 
+#include <errno.h>
+#include <stdlib.h>
+
 #include "batch.h"
 #include "batch_async.h"
 
@@ -14,14 +17,154 @@ namespace leveldown {
 BatchWriteWorker::BatchWriteWorker (
     WriteBatch* batch
   , Nan::Callback *callback
+  , bool owned
 ) : AsyncWorker(batch->database, callback)
   , batch(batch)
-{};
+  , owned(owned)
+  , applied(batch->conditional ? batch->operations.size() : 0)
+  , position(0)
+  , next(0)
+{
+  durable = batch->sync;
+  bytes = batch->bytes;
+  // too big for one txn, it's committed a piece at a time, see Continue()
+  alone = batch->commitBytes != 0 && batch->bytes > batch->commitBytes;
+};
+
+BatchWriteWorker::~BatchWriteWorker () {
+  if (owned)
+    delete batch;
+}
+
+void BatchWriteWorker::Execute () { }
+
+int BatchWriteWorker::Write (MDB_txn *txn) {
+  std::vector< BatchOp >& operations = batch->operations;
+  size_t written = 0;
+
+  for (next = position; next < operations.size(); next++) {
+    if (alone && written >= batch->commitBytes)
+      break;
+
+    bool went;
+    int rc = operations[next].Execute(
+        txn
+      , *batch->arena
+      , batch->parts
+      , went
+    );
+    if (rc != 0 && rc != MDB_NOTFOUND)
+      return rc;
+    if (batch->conditional)
+      applied[next] = went;
+
+    written += operations[next].Bytes();
+  }
+
+  if (alone)
+    bytes = written;
+
+  return 0;
+}
+
+bool BatchWriteWorker::Continue () {
+  position = next;
+  return position < batch->operations.size();
+}
+
+void BatchWriteWorker::Complete () {
+  SetStatus(rc);
+  WorkComplete();
+  Destroy();
+}
+
+// a conditional batch calls back with whether each op went ahead
+void BatchWriteWorker::HandleOKCallback () {
+  Nan::HandleScope scope;
+
+  if (!batch->conditional)
+    return AsyncWorker::HandleOKCallback();
 
-BatchWriteWorker::~BatchWriteWorker () {}
+  v8::Local<v8::Array> returnArray = Nan::New<v8::Array>(applied.size());
+  for (size_t idx = 0; idx < applied.size(); ++idx)
+    returnArray->Set(idx, Nan::New<v8::Boolean>(applied[idx]));
+
+  v8::Local<v8::Value> argv[] = {
+      Nan::Null()
+    , returnArray
+  };
+  callback->Call(2, argv);
+}
+
+/** PACKED BATCH WORKER **/
+
+PackedBatchWorker::PackedBatchWorker (
+    Database* database
+  , Nan::Callback *callback
+  , char* data
+  , size_t size
+  , MDB_dbi dbi
+  , bool sync
+  , bool append
+  , size_t commitBytes
+) : AsyncWorker(database, callback)
+  , data(data)
+  , size(size)
+  , dbi(dbi)
+  , flags(append ? MDB_APPEND : 0)
+  , commitBytes(commitBytes)
+  , position(0)
+  , next(0)
+{
+  durable = sync;
+  bytes = size;
+  alone = commitBytes != 0 && size > commitBytes;
+};
+
+PackedBatchWorker::~PackedBatchWorker () {
+  free(data);
+}
+
+void PackedBatchWorker::Execute () { }
+
+// the copy was checked with ReadPackedOp() before being queued, & nothing
+// else can touch it, but a bad op is still an error rather than a crash
+int PackedBatchWorker::Write (MDB_txn *txn) {
+  const char* end = data + size;
+  const char* from = data + position;
+  PackedOp op;
+
+  while (from < end) {
+    if (alone && (size_t)(from - (data + position)) >= commitBytes)
+      break;
+
+    from = ReadPackedOp(from, end, op);
+    if (from == NULL)
+      return EINVAL;
+
+    int rc = op.type == PACKED_PUT
+      ? mdb_put(txn, dbi, &op.key, &op.value, flags)
+      : mdb_del(txn, dbi, &op.key, NULL);
+    if (rc != 0 && rc != MDB_NOTFOUND)
+      return rc;
+  }
+
+  next = from - data;
+  if (alone)
+    bytes = next - position;
+
+  return 0;
+}
+
+bool PackedBatchWorker::Continue () {
+  position = next;
+  return position < size;
+}
 
-void BatchWriteWorker::Execute () {
-  SetStatus(database->PutToDatabase(batch->operations));
+void PackedBatchWorker::Complete () {
+  SetStatus(rc);
+  WorkComplete();
+  Destroy();
 }
 
 } // namespace leveldown
@@ -15,18 +15,64 @@
 
 namespace leveldown {
 
-class BatchWriteWorker : public AsyncWorker {
+// run by the Database writer thread, see Database::QueueWrite()
+class BatchWriteWorker : public AsyncWorker, public WriteRequest {
 public:
   BatchWriteWorker (
       WriteBatch* batch
     , Nan::Callback *callback
+    , bool owned
   );
 
   virtual ~BatchWriteWorker ();
   virtual void Execute ();
+  virtual int Write (MDB_txn *txn);
+  virtual bool Continue ();
+  virtual void Complete ();
+  virtual void HandleOKCallback ();
 
 private:
   WriteBatch* batch;
+  // an array batch(), that no JS object wraps
+  bool owned;
+  // which ops went ahead, for a `conditional` batch
+  std::vector< bool > applied;
+  // the first op not yet committed, & where this txn got to
+  size_t position;
+  size_t next;
+};
+
+// a batch packed into a single Buffer, executed straight from its bytes
+// with no per-op objects, see packed-batch.js
+class PackedBatchWorker : public AsyncWorker, public WriteRequest {
+public:
+  PackedBatchWorker (
+      Database* database
+    , Nan::Callback *callback
+    , char* data
+    , size_t size
+    , MDB_dbi dbi
+    , bool sync
+    , bool append
+    , size_t commitBytes
+  );
+
+  virtual ~PackedBatchWorker ();
+  virtual void Execute ();
+  virtual int Write (MDB_txn *txn);
+  virtual bool Continue ();
+  virtual void Complete ();
+
+private:
+  // a malloc()ed copy of the Buffer, ours to free
+  char* data;
+  size_t size;
+  MDB_dbi dbi;
+  unsigned int flags;
+  size_t commitBytes;
+  // offsets of the first op not yet committed, & where this txn got to
+  size_t position;
+  size_t next;
 };
 
 } // namespace leveldown
@@ -0,0 +1,341 @@
+/* Copyright (c) 2012-2016 LevelDOWN contributors
+ * See list at <https://github.com/level/leveldown#contributing>
+ * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
+ */
+
+#include <node.h>
+#include <node_buffer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <nan.h>
+
+#include "database.h"
+#include "builder.h"
+#include "builder_async.h"
+#include "common.h"
+
+namespace leveldown {
+
+static Nan::Persistent<v8::FunctionTemplate> builder_constructor;
+
+Builder::Builder (const v8::Local<v8::Value>& from, bool noSubdir)
+  : busy(false)
+  , done(false)
+  , location(new Nan::Utf8String(from))
+  , noSubdir(noSubdir)
+  , build(NULL)
+{};
+
+Builder::~Builder () {
+  // garbage collected without finish()
+  if (build != NULL)
+    Abort();
+  delete location;
+}
+
+/* Calls from worker threads, NO V8 HERE *****************************/
+
+md_status Builder::Open () {
+  md_status status;
+  status.code = 0;
+
+  if (!noSubdir) {
+    const __uv_stat__ stat = Stat(**location);
+    if (stat == NULL) {
+      if (MakeDirectory(**location)) {
+        status.error = std::string(**location);
+        status.error += " cannot be created";
+        return status;
+      }
+    } else if (!IsDirectory(stat)) {
+      status.error = std::string(**location);
+      status.error += " exists and is not a directory";
+      return status;
+    }
+  }
+
+  status.code = mdb_build_open(
+      **location
+    , noSubdir ? MDB_NOSUBDIR : 0
+    , 0664
+    , &build
+  );
+  if (status.code)
+    build = NULL;
+
+  return status;
+}
+
+// the data file is no use to anyone once a build has failed
+void Builder::Abort () {
+  mdb_build_abort(build);
+  build = NULL;
+
+  std::string path(**location);
+  if (!noSubdir)
+    path += "/data.mdb";
+  remove(path.c_str());
+}
+
+md_status Builder::PutMany (const std::vector< MDB_val >& entries) {
+  md_status status;
+  status.code = 0;
+
+  if (done) {
+    status.error = "builder is finished";
+    return status;
+  }
+
+  if (build == NULL) {
+    status = Open();
+    if (build == NULL) {
+      done = true;
+      return status;
+    }
+  }
+
+  // keys & values alternate
+  for (size_t i = 0; i + 1 < entries.size(); i += 2) {
+    MDB_val key = entries[i];
+    MDB_val value = entries[i + 1];
+
+    status.code = mdb_build_put(build, &key, &value);
+    if (status.code) {
+      Abort();
+      done = true;
+      break;
+    }
+  }
+
+  return status;
+}
+
+md_status Builder::Finish () {
+  md_status status;
+  status.code = 0;
+
+  if (done) {
+    status.error = "builder is finished";
+    return status;
+  }
+
+  done = true;
+
+  // nothing was written, build an empty environment
+  if (build == NULL) {
+    status = Open();
+    if (build == NULL)
+      return status;
+  }
+
+  status.code = mdb_build_finish(build);
+  build = NULL;
+
+  if (status.code) {
+    std::string path(**location);
+    if (!noSubdir)
+      path += "/data.mdb";
+    remove(path.c_str());
+  }
+
+  return status;
+}
+
+/* V8 exposed functions *****************************/
+
+NAN_METHOD(NewBuilder) {
+  v8::Local<v8::String> location = info[0].As<v8::String>();
+  v8::Local<v8::Object> optionsObj;
+
+  if (info.Length() > 1 && info[1]->IsObject())
+    optionsObj = info[1].As<v8::Object>();
+
+  info.GetReturnValue().Set(Builder::NewInstance(location, optionsObj));
+}
+
+void Builder::Init () {
+  v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(Builder::New);
+  builder_constructor.Reset(tpl);
+  tpl->SetClassName(Nan::New("Builder").ToLocalChecked());
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+  Nan::SetPrototypeMethod(tpl, "write", Builder::Write);
+  Nan::SetPrototypeMethod(tpl, "finish", Builder::Finish);
+}
+
+NAN_METHOD(Builder::New) {
+  v8::Local<v8::Object> optionsObj;
+
+  if (info.Length() > 1 && info[1]->IsObject())
+    optionsObj = info[1].As<v8::Object>();
+
+  Builder* obj = new Builder(
+      info[0]
+    , BooleanOptionValue(optionsObj, "noSubdir", DEFAULT_NOSUBDIR)
+  );
+  obj->Wrap(info.This());
+
+  info.GetReturnValue().Set(info.This());
+}
+
+v8::Local<v8::Value> Builder::NewInstance (
+        v8::Local<v8::String> &location
+      , v8::Local<v8::Object> optionsObj
+    ) {
+
+  Nan::EscapableHandleScope scope;
+
+  Nan::MaybeLocal<v8::Object> maybeInstance;
+  v8::Local<v8::Object> instance;
+
+  v8::Local<v8::FunctionTemplate> constructorHandle =
+      Nan::New<v8::FunctionTemplate>(builder_constructor);
+
+  if (optionsObj.IsEmpty()) {
+    v8::Local<v8::Value> argv[1] = { location };
+    maybeInstance = Nan::NewInstance(constructorHandle->GetFunction(), 1, argv);
+  } else {
+    v8::Local<v8::Value> argv[2] = { location, optionsObj };
+    maybeInstance = Nan::NewInstance(constructorHandle->GetFunction(), 2, argv);
+  }
+
+  if (maybeInstance.IsEmpty())
+    Nan::ThrowError("Could not create new Builder instance");
+  else
+    instance = maybeInstance.ToLocalChecked();
+
+  return scope.Escape(instance);
+}
+
+// copies at most `room` bytes, `from` being a Buffer or a String
+static size_t CopyStringOrBuffer (
+      v8::Local<v8::Value> from
+    , char* to
+    , size_t room) {
+
+  if (node::Buffer::HasInstance(from)) {
+    size_t size = node::Buffer::Length(from);
+    if (size > room)
+      size = room;
+    if (size > 0)
+      memcpy(to, node::Buffer::Data(from), size);
+    return size;
+  }
+
+  return from.As<v8::String>()->WriteUtf8(
+      to
+    , (int)room
+    , NULL
+    , v8::String::NO_NULL_TERMINATION
+  );
+}
+
+NAN_METHOD(Builder::Write) {
+  Builder* builder = ObjectWrap::Unwrap<Builder>(info.Holder());
+
+  if (info.Length() < 2 || !info[1]->IsFunction())
+    return Nan::ThrowError("write() requires a callback argument");
+
+  v8::Local<v8::Function> callback = info[1].As<v8::Function>();
+
+  if (!info[0]->IsArray()) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "write() requires an array of entries")
+  }
+
+  if (builder->busy) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "a write() or finish() is in progress")
+  }
+
+  if (builder->done) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "builder is finished")
+  }
+
+  v8::Local<v8::Array> array = info[0].As<v8::Array>();
+  v8::Local<v8::String> keyName = Nan::New("key").ToLocalChecked();
+  v8::Local<v8::String> valueName = Nan::New("value").ToLocalChecked();
+
+  // size everything up first so it can all be copied into a single block,
+  // the worker can't look at the JS values. What's sized is kept for the
+  // copy, a getter or toString() asked twice could give something longer
+  std::vector< v8::Local<v8::Value> > parts;
+  parts.reserve(array->Length() * 2);
+  size_t total = 0;
+  for (uint32_t i = 0; i < array->Length(); i++) {
+    if (!array->Get(i)->IsObject()) {
+      LD_RETURN_CALLBACK_OR_ERROR(callback, "entries must be objects")
+    }
+
+    v8::Local<v8::Object> obj = array->Get(i).As<v8::Object>();
+    v8::Local<v8::Value> key = obj->Get(keyName);
+    v8::Local<v8::Value> value = obj->Get(valueName);
+
+    LD_CB_ERR_IF_NULL_OR_UNDEFINED(key, key)
+    LD_CB_ERR_IF_NULL_OR_UNDEFINED(value, value)
+
+    if (!node::Buffer::HasInstance(key))
+      key = key->ToString();
+    if (!node::Buffer::HasInstance(value))
+      value = value->ToString();
+
+    total += StringOrBufferLength(key) + StringOrBufferLength(value);
+    parts.push_back(key);
+    parts.push_back(value);
+  }
+
+  char* data = (char*)malloc(total > 0 ? total : 1);
+  std::vector< MDB_val >* entries = new std::vector< MDB_val >();
+  entries->reserve(parts.size());
+
+  char* at = data;
+  for (size_t i = 0; i < parts.size(); i++) {
+    MDB_val val;
+
+    val.mv_data = at;
+    val.mv_size = CopyStringOrBuffer(parts[i], at, total - (at - data));
+    at += val.mv_size;
+    entries->push_back(val);
+  }
+
+  builder->busy = true;
+
+  BuilderWriteWorker* worker = new BuilderWriteWorker(
+      builder
+    , new Nan::Callback(callback)
+    , data
+    , entries
+  );
+  // persist to prevent accidental GC
+  v8::Local<v8::Object> _this = info.This();
+  worker->SaveToPersistent("builder", _this);
+  Nan::AsyncQueueWorker(worker);
+}
+
+NAN_METHOD(Builder::Finish) {
+  Builder* builder = ObjectWrap::Unwrap<Builder>(info.Holder());
+
+  if (info.Length() < 1 || !info[0]->IsFunction())
+    return Nan::ThrowError("finish() requires a callback argument");
+
+  v8::Local<v8::Function> callback = info[0].As<v8::Function>();
+
+  if (builder->busy) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "a write() or finish() is in progress")
+  }
+
+  if (builder->done) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "builder is finished")
+  }
+
+  builder->busy = true;
+
+  BuilderFinishWorker* worker = new BuilderFinishWorker(
+      builder
+    , new Nan::Callback(callback)
+  );
+  // persist to prevent accidental GC
+  v8::Local<v8::Object> _this = info.This();
+  worker->SaveToPersistent("builder", _this);
+  Nan::AsyncQueueWorker(worker);
+}
+
+} // namespace leveldown
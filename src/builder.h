@@ -0,0 +1,60 @@
+/* Copyright (c) 2012-2016 LevelDOWN contributors
+ * See list at <https://github.com/level/leveldown#contributing>
+ * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
+ */
+
+#ifndef LD_BUILDER_H
+#define LD_BUILDER_H
+
+#include <vector>
+#include <node.h>
+#include <nan.h>
+
+#include "leveldown.h"
+
+namespace leveldown {
+
+NAN_METHOD(NewBuilder);
+
+/*
+ * Builds a new environment from sorted entries with mdb_build_*(), see
+ * lmdb.h: packed pages are written out in order as entries arrive, no
+ * txns, no page splits. The data file only becomes a valid environment
+ * once Finish() has succeeded, a failed build removes it.
+ */
+class Builder : public Nan::ObjectWrap {
+public:
+  static void Init ();
+  static v8::Local<v8::Value> NewInstance (
+      v8::Local<v8::String> &location
+    , v8::Local<v8::Object> optionsObj
+  );
+
+  Builder (const v8::Local<v8::Value>& from, bool noSubdir);
+  ~Builder ();
+
+  // called from worker threads, NO V8 HERE
+  md_status PutMany (const std::vector< MDB_val >& entries);
+  md_status Finish ();
+
+  // a write() or finish() is running
+  bool busy;
+  // finished or abandoned, nothing more can be written
+  bool done;
+
+private:
+  Nan::Utf8String* location;
+  bool noSubdir;
+  MDB_build* build;
+
+  md_status Open ();
+  void Abort ();
+
+  static NAN_METHOD(New);
+  static NAN_METHOD(Write);
+  static NAN_METHOD(Finish);
+};
+
+} // namespace leveldown
+
+#endif
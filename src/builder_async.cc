@@ -0,0 +1,60 @@
+/* Copyright (c) 2012-2016 LevelDOWN contributors
+ * See list at <https://github.com/level/leveldown#contributing>
+ * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
+ */
+
+#include <stdlib.h>
+
+#include "builder.h"
+#include "builder_async.h"
+
+namespace leveldown {
+
+/** BUILDER WRITE WORKER **/
+
+BuilderWriteWorker::BuilderWriteWorker (
+    Builder* builder
+  , Nan::Callback *callback
+  , char* data
+  , std::vector< MDB_val >* entries
+) : AsyncWorker(NULL, callback)
+  , builder(builder)
+  , data(data)
+  , entries(entries)
+{};
+
+BuilderWriteWorker::~BuilderWriteWorker () {
+  free(data);
+  delete entries;
+}
+
+void BuilderWriteWorker::Execute () {
+  SetStatus(builder->PutMany(*entries));
+}
+
+void BuilderWriteWorker::WorkComplete () {
+  builder->busy = false;
+  AsyncWorker::WorkComplete();
+}
+
+/** BUILDER FINISH WORKER **/
+
+BuilderFinishWorker::BuilderFinishWorker (
+    Builder* builder
+  , Nan::Callback *callback
+) : AsyncWorker(NULL, callback)
+  , builder(builder)
+{};
+
+BuilderFinishWorker::~BuilderFinishWorker () {}
+
+void BuilderFinishWorker::Execute () {
+  SetStatus(builder->Finish());
+}
+
+void BuilderFinishWorker::WorkComplete () {
+  builder->busy = false;
+  AsyncWorker::WorkComplete();
+}
+
+} // namespace leveldown
@@ -0,0 +1,54 @@
+/* Copyright (c) 2012-2016 LevelDOWN contributors
+ * See list at <https://github.com/level/leveldown#contributing>
+ * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
+ */
+
+#ifndef LD_BUILDER_ASYNC_H
+#define LD_BUILDER_ASYNC_H
+
+#include <vector>
+#include <node.h>
+
+#include "async.h"
+#include "builder.h"
+
+namespace leveldown {
+
+class BuilderWriteWorker : public AsyncWorker {
+public:
+  BuilderWriteWorker (
+      Builder* builder
+    , Nan::Callback *callback
+    , char* data
+    , std::vector< MDB_val >* entries
+  );
+
+  virtual ~BuilderWriteWorker ();
+  virtual void Execute ();
+  virtual void WorkComplete ();
+
+private:
+  Builder* builder;
+  // every key & value, back to back, `entries` point into it
+  char* data;
+  std::vector< MDB_val >* entries;
+};
+
+class BuilderFinishWorker : public AsyncWorker {
+public:
+  BuilderFinishWorker (
+      Builder* builder
+    , Nan::Callback *callback
+  );
+
+  virtual ~BuilderFinishWorker ();
+  virtual void Execute ();
+  virtual void WorkComplete ();
+
+private:
+  Builder* builder;
+};
+
+} // namespace leveldown
+
+#endif
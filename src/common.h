@@ -6,10 +6,34 @@
 #ifndef LD_COMMON_H
 #define LD_COMMON_H
 
+#include <sys/stat.h>
 #include <nan.h>
 
 namespace leveldown {
 
+#if (NODE_MODULE_VERSION > 0x000B)
+  typedef uv_stat_t * __uv_stat__;
+#else
+  typedef uv_statbuf_t * __uv_stat__;
+#endif
+
+inline __uv_stat__ Stat (const char* path) {
+  uv_fs_t req;
+  int result = uv_fs_lstat(uv_default_loop(), &req, path, NULL);
+  if (result < 0)
+    return NULL;
+  return static_cast<const __uv_stat__>(req.ptr);
+}
+
+inline bool IsDirectory (const __uv_stat__ stat) {
+  return (stat->st_mode & S_IFMT) == S_IFDIR;
+}
+
+inline bool MakeDirectory (const char* path) {
+  uv_fs_t req;
+  return uv_fs_mkdir(uv_default_loop(), &req, path, 511, NULL);
+}
+
 NAN_INLINE bool BooleanOptionValue(v8::Local<v8::Object> options,
                                    const char* _key,
                                    bool def = false) {
@@ -47,6 +71,18 @@ NAN_INLINE uint64_t UInt64OptionValue(
       : def;
 }
 
+// the id of the `subdb` handle in `options` (see subdb.js), 0 for none,
+// see Database::ResolveDbi()
+NAN_INLINE uint32_t SubDbOptionValue(v8::Local<v8::Object> options) {
+  Nan::HandleScope scope;
+  v8::Local<v8::String> key = Nan::New("subdb").ToLocalChecked();
+  return !options.IsEmpty()
+    && options->Has(key)
+    && options->Get(key)->IsObject()
+    ? UInt32OptionValue(options->Get(key).As<v8::Object>(), "id", 0)
+    : 0;
+}
+
 } // namespace leveldown
 
 #endif
@@ -13,46 +13,58 @@
 #include "async.h"
 #include "database_async.h"
 #include "batch.h"
+#include "batch_async.h"
 #include "iterator.h"
+#include "snapshot.h"
 #include "common.h"
 
+#include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sstream>
+#include <algorithm>
 
 namespace leveldown {
 
 static Nan::Persistent<v8::FunctionTemplate> database_constructor;
 
-#if (NODE_MODULE_VERSION > 0x000B)
-  typedef uv_stat_t * __uv_stat__;
-#else
-  typedef uv_statbuf_t * __uv_stat__;
-#endif
-
-inline __uv_stat__ Stat (const char* path) {
-  uv_fs_t req;
-  int result = uv_fs_lstat(uv_default_loop(), &req, path, NULL);
-  if (result < 0)
-    return NULL;
-  return static_cast<const __uv_stat__>(req.ptr);
-}
-
-inline bool IsDirectory (const __uv_stat__ stat) {
-  return (stat->st_mode & S_IFMT) == S_IFDIR;
-}
-
-inline bool MakeDirectory (const char* path) {
-  uv_fs_t req;
-  return uv_fs_mkdir(uv_default_loop(), &req, path, 511, NULL);
-}
-
 Database::Database (const v8::Local<v8::Value>& from)
   : location(new Nan::Utf8String(from))
   , currentIteratorId(0)
   , pendingCloseWorker(NULL)
-{};
+  , sharedEnv(NULL)
+  , namedDbs(false)
+  , lastSubDbId(0)
+  , poolReads(false)
+  , zeroCopy(false)
+  , maxPinnedTxns(0)
+  , writerStop(false)
+  , heldWrite(NULL)
+  , completeAsync(NULL)
+  , pendingWrites(0)
+  , writable(false)
+  , deferredSync(false)
+  , autoGrow(false)
+  , mapSize(0)
+  , maxMapSize(0)
+  , mapGeneration(0)
+  , mapResized(false)
+  , onMapResize(NULL)
+  , envInfoRc(EINVAL)
+  , envStatRc(EINVAL)
+{
+  uv_mutex_init(&readPoolMutex);
+  uv_mutex_init(&dbiMutex);
+  uv_rwlock_init(&mapLock);
+  uv_mutex_init(&mapGate);
+};
 
 Database::~Database () {
+  uv_mutex_destroy(&readPoolMutex);
+  uv_mutex_destroy(&dbiMutex);
+  uv_rwlock_destroy(&mapLock);
+  uv_mutex_destroy(&mapGate);
+  delete onMapResize;
   delete location;
 };
 
@@ -135,6 +147,24 @@ md_status Database::OpenDatabase (OpenOptions options) {
   if (options.noSubdir)
     env_opt |= MDB_NOSUBDIR;
 
+  // commits aren't durable on their own, "durable" writes have to wait
+  // for the flusher thread's next mdb_env_sync()
+  deferredSync = !options.readOnly
+    && (!options.sync || !options.metaSync || options.mapAsync);
+  flushInterval = options.flushInterval;
+  flushBytes = options.flushBytes;
+
+  // a reset txn keeps its reader slot, with thread-local slots it can't be
+  // handed to a different thread (or coexist with a new txn on this one)
+  poolReads = !options.notls;
+  zeroCopy = poolReads && !options.writeMap;
+  // the rest of the reader table is left to the read pool, snapshots,
+  // iterators & other processes
+  maxPinnedTxns = std::max((uint64_t)1, options.maxReaders / 2);
+
+  autoGrow = options.autoGrow && !options.readOnly;
+  maxMapSize = options.maxMapSize;
+
   status.code = mdb_env_create(&env);
   if (status.code)
     return status;
@@ -151,6 +181,16 @@ md_status Database::OpenDatabase (OpenOptions options) {
     return status;
   }
 
+  namedDbs = options.maxDbs > 0;
+
+  if (namedDbs) {
+    status.code = mdb_env_set_maxdbs(env, options.maxDbs);
+    if (status.code) {
+      mdb_env_close(env);
+      return status;
+    }
+  }
+
   status.code = mdb_env_open(env, **location, env_opt, 0664);
   if (status.code) {
     mdb_env_close(env);
@@ -179,153 +219,834 @@ md_status Database::OpenDatabase (OpenOptions options) {
     return status;
   }
 
+  // an existing env may already be larger than `mapSize`
+  MDB_envinfo info;
+  mdb_env_info(env, &info);
+  mapSize = info.me_mapsize;
+
+  sharedEnv = new SharedEnv;
+  sharedEnv->env = env;
+  sharedEnv->refs = 1;
+  sharedEnv->pins = 0;
+  uv_mutex_init(&sharedEnv->pinMutex);
+  sharedEnv->latestPin = NULL;
+  sharedEnv->pinnedTxns = 0;
+
   return status;
 }
 
+void ReleaseEnv (SharedEnv* sharedEnv) {
+  if (--sharedEnv->refs == 0) {
+    mdb_env_close(sharedEnv->env);
+    uv_mutex_destroy(&sharedEnv->pinMutex);
+    delete sharedEnv;
+  }
+}
+
 void Database::CloseDatabase () {
-  mdb_env_close(env);
+  if (sharedEnv == NULL)
+    return;
+
+  StopWriter();
+  DrainReadPool();
+  ReleaseEnv(sharedEnv);
+  sharedEnv = NULL;
 }
 
-int Database::PutToDatabase (MDB_val key, MDB_val value) {
+/*
+ * Named dbs are opened (and created) in their own txn, up front, so that
+ * the handle can be used by any txn after. The writer thread never opens
+ * dbs and `dbiMutex` keeps this to one txn at a time, as LMDB requires.
+ * Creating one waits on the writer's current txn, so subdb() with a
+ * callback does this on the threadpool, holding `sharedEnv` meanwhile.
+ */
+int Database::OpenSubDatabase (
+      SharedEnv* sharedEnv
+    , const char* name
+    , unsigned int flags
+    , MDB_dbi* dbi) {
+
   int rc;
   MDB_txn *txn;
+  unsigned int envFlags;
 
-  rc = mdb_txn_begin(env, NULL, 0, &txn);
-  if (rc)
-    return rc;
+  if (sharedEnv == NULL)
+    return EINVAL;
 
-  rc = mdb_put(txn, dbi, &key, &value, 0);
-  if (rc) {
-    mdb_txn_abort(txn);
-    return rc;
+  mdb_env_get_flags(sharedEnv->env, &envFlags);
+  if (envFlags & MDB_RDONLY)
+    flags &= ~MDB_CREATE;
+
+  uv_mutex_lock(&dbiMutex);
+  LockMap();
+
+  rc = mdb_txn_begin(
+      sharedEnv->env
+    , NULL
+    , flags & MDB_CREATE ? 0 : MDB_RDONLY
+    , &txn
+  );
+  if (rc == 0) {
+    rc = mdb_dbi_open(txn, name, flags, dbi);
+    if (rc)
+      mdb_txn_abort(txn);
+    else
+      rc = mdb_txn_commit(txn);
   }
 
-  rc = mdb_txn_commit(txn);
+  UnlockMap();
+  uv_mutex_unlock(&dbiMutex);
 
   return rc;
 }
 
-int Database::PutToDatabase (std::vector< BatchOp* >* operations) {
+// called in the main thread, the id for handles on `name`, see subDbs
+uint32_t Database::RegisterSubDb (const std::string& name, MDB_dbi dbi) {
+  std::map< std::string, uint32_t >::iterator it = subDbIds.find(name);
+  if (it != subDbIds.end())
+    return it->second;
+
+  uint32_t id = ++lastSubDbId;
+  subDbIds[name] = id;
+  subDbs[id] = dbi;
+  return id;
+}
+
+// called in the main thread, false if sub-db `id` has been dropped (or the
+// database closed since), 0 is `def`
+bool Database::ResolveDbi (uint32_t id, MDB_dbi def, MDB_dbi& dbi) {
+  if (id == 0) {
+    dbi = def;
+    return true;
+  }
+
+  std::map< uint32_t, MDB_dbi >::iterator it = subDbs.find(id);
+  if (it == subDbs.end())
+    return false;
+
+  dbi = it->second;
+  return true;
+}
+
+void Database::ForgetSubDb (uint32_t id) {
+  subDbs.erase(id);
+  for (std::map< std::string, uint32_t >::iterator it = subDbIds.begin()
+      ; it != subDbIds.end()
+      ; ++it) {
+    if (it->second == id) {
+      subDbIds.erase(it);
+      return;
+    }
+  }
+}
+
+/*
+ * Read txns are reset into a small pool when finished with rather than
+ * aborted and renewed from it next time, which keeps their reader slot
+ * and skips the reader table lock & setup that mdb_txn_begin() costs. The
+ * pool is shared by all threads, with MDB_NOTLS a txn isn't tied to the
+ * thread that created it. Reads given a `snapshot` use its txn instead.
+ */
+int Database::AcquireReadTxn (MDB_txn **txn, leveldown::Snapshot* snapshot) {
   int rc;
-  MDB_txn *txn;
 
-  rc = mdb_txn_begin(env, NULL, 0, &txn);
-  if (rc)
-    return rc;
+  if (snapshot != NULL)
+    return snapshot->Lock(txn);
 
-  for (std::vector< BatchOp* >::iterator it = operations->begin()
-      ; it != operations->end()
-      ; it++) {
+  if (poolReads) {
+    uv_mutex_lock(&readPoolMutex);
+    if (!txnPool.empty()) {
+      *txn = txnPool.back();
+      txnPool.pop_back();
+      uv_mutex_unlock(&readPoolMutex);
 
-    rc = (*it)->Execute(txn, dbi);
-    if (rc != 0 && rc != MDB_NOTFOUND) {
-      mdb_txn_abort(txn);
-      return rc;
+      rc = mdb_txn_renew(*txn);
+      if (rc == 0)
+        return rc;
+      mdb_txn_abort(*txn);
+    } else {
+      uv_mutex_unlock(&readPoolMutex);
+    }
+  }
+
+  rc = mdb_txn_begin(env, NULL, MDB_RDONLY, txn);
+
+  if (rc == MDB_READERS_FULL && poolReads) {
+    // the pool may be sitting on the slots we need
+    DrainReadPool();
+    rc = mdb_txn_begin(env, NULL, MDB_RDONLY, txn);
+  }
+
+  if (rc == MDB_MAP_RESIZED && autoGrow) {
+    // another process grew the map, adopt its size. Callers hold the map
+    // lock but nothing in the map yet, so can let go of it meanwhile
+    uint32_t generation = mapGeneration.load();
+    UnlockMap();
+    ResizeMap(0, generation);
+    LockMap();
+    rc = mdb_txn_begin(env, NULL, MDB_RDONLY, txn);
+  }
+
+  return rc;
+}
+
+void Database::ReleaseReadTxn (MDB_txn *txn, leveldown::Snapshot* snapshot) {
+  if (snapshot != NULL) {
+    snapshot->Unlock();
+    return;
+  }
+
+  if (poolReads) {
+    mdb_txn_reset(txn);
+
+    uv_mutex_lock(&readPoolMutex);
+    if (txnPool.size() < READ_POOL_MAX) {
+      txnPool.push_back(txn);
+      txn = NULL;
     }
+    uv_mutex_unlock(&readPoolMutex);
+
+    if (txn == NULL)
+      return;
+  }
+
+  mdb_txn_abort(txn);
+}
+
+void Database::DrainReadPool () {
+  uv_mutex_lock(&readPoolMutex);
+
+  for (std::vector< MDB_cursor* >::iterator it = cursorPool.begin()
+      ; it != cursorPool.end()
+      ; ++it) {
+    mdb_cursor_close(*it);
   }
+  cursorPool.clear();
 
-  rc = mdb_txn_commit(txn);
+  for (std::vector< MDB_txn* >::iterator it = txnPool.begin()
+      ; it != txnPool.end()
+      ; ++it) {
+    mdb_txn_abort(*it);
+  }
+  txnPool.clear();
+
+  uv_mutex_unlock(&readPoolMutex);
+}
+
+/*
+ * Called in the main thread, a read txn for a Snapshot to hold for as long
+ * as JS keeps it, along with a reference to the env so that it can outlive
+ * the Database being closed, as with zero-copy pins. The txn survives the
+ * map being resized, it's only cursors that need repositioning.
+ */
+int Database::BeginSnapshot (MDB_txn **txn, SharedEnv **sharedEnv) {
+  if (this->sharedEnv == NULL)
+    return EINVAL;
+
+  *txn = NULL;
+  this->sharedEnv->refs++;
+  *sharedEnv = this->sharedEnv;
+
+  // called in the main thread, which mustn't wait on a resize: the txn is
+  // then begun by the first read, see Snapshot::Lock()
+  if (!TryLockMap())
+    return 0;
+  int rc = BeginSnapshotTxn(env, txn);
+  if (rc == MDB_READERS_FULL && poolReads) {
+    // the pool may be sitting on the slots we need
+    DrainReadPool();
+    rc = BeginSnapshotTxn(env, txn);
+  }
+  UnlockMap();
+
+  if (rc == MDB_MAP_RESIZED)
+    return 0;
+  if (rc != 0)
+    ReleaseEnv(this->sharedEnv);
 
   return rc;
 }
 
-int Database::GetFromDatabase (MDB_val key, std::string& value) {
+/*
+ * A txn of its own rather than one from the read pool, it's held for as
+ * long as JS keeps the snapshot. Called holding the map lock; a map grown
+ * by another process isn't adopted here, as that would wait on reads that
+ * may be waiting on the snapshot, MDB_MAP_RESIZED is left to the next read
+ * without one to adopt.
+ */
+int BeginSnapshotTxn (MDB_env* env, MDB_txn **txn) {
+  return mdb_txn_begin(env, NULL, MDB_RDONLY, txn);
+}
+
+// copy into malloc()ed memory that a Buffer can take ownership of
+static int CopyValue (MDB_val& to, const MDB_val& from) {
+  to.mv_size = from.mv_size;
+  to.mv_data = malloc(from.mv_size > 0 ? from.mv_size : 1);
+  if (to.mv_data == NULL)
+    return ENOMEM;
+  memcpy(to.mv_data, from.mv_data, from.mv_size);
+  return 0;
+}
+
+int Database::GetFromDatabase (
+      MDB_dbi dbi
+    , MDB_val key
+    , MDB_val& value
+    , leveldown::Snapshot* snapshot) {
+
   int rc;
   MDB_txn *txn;
   MDB_val val;
 
-  rc = mdb_txn_begin(env, NULL, MDB_RDONLY, &txn);
-  if (rc)
-    return rc;
+  LockMap();
 
-  rc = mdb_get(txn, dbi, &key, &val);
+  rc = AcquireReadTxn(&txn, snapshot);
   if (rc) {
-    mdb_txn_abort(txn);
+    UnlockMap();
     return rc;
   }
 
+  rc = mdb_get(txn, dbi, &key, &val);
+
   // We need to copy the data before the txn
-  // is committed, lest we end up with a nasty
+  // is released, lest we end up with a nasty
   // race condition on the next update.
-  value.assign((char*)val.mv_data, val.mv_size);
+  if (rc == 0)
+    rc = CopyValue(value, val);
 
-  rc = mdb_txn_commit(txn);
+  ReleaseReadTxn(txn, snapshot);
+  UnlockMap();
 
   return rc;
 }
 
-int Database::DeleteFromDatabase (MDB_val key) {
+// as GetFromDatabase() but copying out only part of the value, so a slice
+// of a large overflow value costs no more than the slice; `size` is set to
+// the size of the whole value
+int Database::GetRangeFromDatabase (
+      MDB_dbi dbi
+    , MDB_val key
+    , uint64_t offset
+    , uint64_t length
+    , MDB_val& value
+    , size_t& size
+    , leveldown::Snapshot* snapshot) {
+
   int rc;
   MDB_txn *txn;
+  MDB_val val;
 
-  rc = mdb_txn_begin(env, NULL, 0, &txn);
-  if (rc)
-    return rc;
+  LockMap();
 
-  rc = mdb_del(txn, dbi, &key, NULL);
-  if (rc != 0 && rc != MDB_NOTFOUND) {
-    mdb_txn_abort(txn);
+  rc = AcquireReadTxn(&txn, snapshot);
+  if (rc) {
+    UnlockMap();
     return rc;
   }
 
-  rc = mdb_txn_commit(txn);
+  rc = mdb_get(txn, dbi, &key, &val);
+
+  if (rc == 0) {
+    size = val.mv_size;
+    SliceValue(val, offset, length);
+    rc = CopyValue(value, val);
+  }
+
+  ReleaseReadTxn(txn, snapshot);
+  UnlockMap();
+
+  return rc;
+}
+
+/*
+ * Zero copy: `value` points straight into the map and stays valid for as
+ * long as the read txn is held open, which the caller hands to the Buffer
+ * wrapping it via `pin` and NewPinnedBuffer(). The caller holds a
+ * reference to `sharedEnv`, the pin takes one of its own: pins can be
+ * released after the Database (but not the env) is closed, so pinned txns
+ * are never given back to the pool.
+ *
+ * Reads share one pinned txn for as long as it's on the latest data, and
+ * only a few are let open at once so that Buffers kept around can't take
+ * up the reader table; MDB_READERS_FULL then tells the caller to copy the
+ * value out instead.
+ */
+// drops a Buffer from a pinned txn, the last one aborting it
+static void DropPinnedTxn (SharedEnv* sharedEnv, PinnedTxn* pinned) {
+  uv_mutex_lock(&sharedEnv->pinMutex);
+  if (--pinned->buffers == 0) {
+    if (sharedEnv->latestPin == pinned)
+      sharedEnv->latestPin = NULL;
+    mdb_txn_abort(pinned->txn);
+    sharedEnv->pinnedTxns--;
+    delete pinned;
+  }
+  uv_mutex_unlock(&sharedEnv->pinMutex);
+}
+
+int Database::GetPinnedFromDatabase (
+      SharedEnv* sharedEnv
+    , MDB_dbi dbi
+    , MDB_val key
+    , MDB_val& value
+    , PinnedRead** pin) {
+
+  int rc;
+  MDB_envinfo info;
+
+  LockMap();
+
+  uv_mutex_lock(&sharedEnv->pinMutex);
+  PinnedTxn* pinned = sharedEnv->latestPin;
+  if (pinned != NULL) {
+    mdb_env_info(sharedEnv->env, &info);
+    if (mdb_txn_id(pinned->txn) != info.me_last_txnid) {
+      // left to the Buffers already read from it
+      sharedEnv->latestPin = pinned = NULL;
+    }
+  }
+  if (pinned != NULL) {
+    pinned->buffers++;
+  } else if (sharedEnv->pinnedTxns >= maxPinnedTxns) {
+    uv_mutex_unlock(&sharedEnv->pinMutex);
+    UnlockMap();
+    return MDB_READERS_FULL;
+  } else {
+    sharedEnv->pinnedTxns++;
+  }
+  uv_mutex_unlock(&sharedEnv->pinMutex);
+
+  if (pinned == NULL) {
+    // not under pinMutex, adopting a resize waits on other reads
+    MDB_txn *txn;
+    rc = AcquireReadTxn(&txn);
+    if (rc) {
+      uv_mutex_lock(&sharedEnv->pinMutex);
+      sharedEnv->pinnedTxns--;
+      uv_mutex_unlock(&sharedEnv->pinMutex);
+      UnlockMap();
+      return rc;
+    }
+    pinned = new PinnedTxn;
+    pinned->txn = txn;
+    pinned->buffers = 1;
+
+    uv_mutex_lock(&sharedEnv->pinMutex);
+    sharedEnv->latestPin = pinned;
+    uv_mutex_unlock(&sharedEnv->pinMutex);
+  }
+
+  // a txn is only to be used by one thread at a time
+  uv_mutex_lock(&sharedEnv->pinMutex);
+  rc = mdb_get(pinned->txn, dbi, &key, &value);
+  uv_mutex_unlock(&sharedEnv->pinMutex);
+
   if (rc) {
-    mdb_txn_abort(txn);
+    UnlockMap();
+    DropPinnedTxn(sharedEnv, pinned);
     return rc;
   }
 
+  sharedEnv->pins++;
+  UnlockMap();
+
+  sharedEnv->refs++;
+  *pin = new PinnedRead;
+  (*pin)->sharedEnv = sharedEnv;
+  (*pin)->pinned = pinned;
+  (*pin)->data = NULL;
+  (*pin)->size = 0;
+  (*pin)->released = false;
+
   return rc;
 }
 
-int Database::NewCursor (MDB_txn **txn, MDB_cursor **cursor) {
+/*
+ * Live zero-copy Buffers by their data, for releaseBuffer() to find them.
+ * Main thread only.
+ */
+static std::multimap< const char*, PinnedRead* > pinnedBuffers;
+
+// called in the main thread, a Buffer holding `pin` until it's released
+v8::Local<v8::Object> Database::NewPinnedBuffer (
+      MDB_val value
+    , PinnedRead* pin) {
+
+  pin->data = (const char*)value.mv_data;
+  pin->size = value.mv_size;
+  pinnedBuffers.insert(std::make_pair(pin->data, pin));
+
+  return Nan::NewBuffer(
+      (char*)value.mv_data
+    , value.mv_size
+    , Database::ReleasePinned
+    , pin
+  ).ToLocalChecked();
+}
+
+// called when a zero-copy Buffer is garbage collected
+void Database::ReleasePinned (char* data, void* hint) {
+  PinnedRead* pin = static_cast<PinnedRead*>(hint);
+  if (!pin->released)
+    Unpin(pin);
+  delete pin;
+}
+
+/*
+ * Called in the main thread, lets go of the read txn (& env) a pin holds,
+ * the last Buffer on a pinned txn aborting it. The PinnedRead itself is
+ * left to the Buffer's free callback.
+ */
+void Database::Unpin (PinnedRead* pin) {
+  SharedEnv* sharedEnv = pin->sharedEnv;
+
+  if (pin->data != NULL) {
+    std::pair<
+        std::multimap< const char*, PinnedRead* >::iterator
+      , std::multimap< const char*, PinnedRead* >::iterator
+    > range = pinnedBuffers.equal_range(pin->data);
+    for (std::multimap< const char*, PinnedRead* >::iterator it = range.first
+        ; it != range.second
+        ; ++it) {
+      if (it->second == pin) {
+        pinnedBuffers.erase(it);
+        break;
+      }
+    }
+  }
+
+  DropPinnedTxn(sharedEnv, pin->pinned);
+
+  pin->released = true;
+  sharedEnv->pins--;
+  ReleaseEnv(sharedEnv);
+}
+
+// orders indexes into a list of keys by the database's key comparison
+class KeyIndexCompare {
+public:
+  KeyIndexCompare (MDB_txn *txn, MDB_dbi dbi, std::vector< MDB_val* >& keys)
+    : txn(txn), dbi(dbi), keys(keys) {}
+
+  bool operator() (size_t a, size_t b) const {
+    return mdb_cmp(txn, dbi, keys[a], keys[b]) < 0;
+  }
+
+private:
+  MDB_txn *txn;
+  MDB_dbi dbi;
+  std::vector< MDB_val* >& keys;
+};
+
+/*
+ * Looks up every key in a single read txn. `values` ends up parallel to
+ * `keys`, holding malloc()ed copies, or NULL data for keys that weren't
+ * found (or were NULL themselves). With
+ * `sort` the keys are visited in tree order with one cursor, so lookups on
+ * the same leaf as the previous one don't descend from the root again.
+ */
+int Database::GetManyFromDatabase (
+      MDB_dbi dbi
+    , std::vector< MDB_val* >& keys
+    , bool sort
+    , std::vector< MDB_val >& values
+    , leveldown::Snapshot* snapshot) {
+
   int rc;
+  MDB_txn *txn;
+  MDB_val val;
+  MDB_val missing;
 
-  rc = mdb_txn_begin(env, NULL, MDB_RDONLY, txn);
+  missing.mv_size = 0;
+  missing.mv_data = NULL;
+  values.assign(keys.size(), missing);
+
+  LockMap();
+
+  if (!sort) {
+    rc = AcquireReadTxn(&txn, snapshot);
+    if (rc) {
+      UnlockMap();
+      return rc;
+    }
+
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (keys[i] == NULL)
+        continue;
+
+      rc = mdb_get(txn, dbi, keys[i], &val);
+      if (rc == MDB_NOTFOUND)
+        continue;
+      if (rc || (rc = CopyValue(values[i], val)))
+        break;
+    }
+
+    ReleaseReadTxn(txn, snapshot);
+    UnlockMap();
+
+    return rc == MDB_NOTFOUND ? 0 : rc;
+  }
+
+  MDB_cursor *cursor;
+  std::vector< size_t > order;
+
+  rc = NewCursor(dbi, &txn, &cursor, snapshot);
+  if (rc) {
+    UnlockMap();
+    return rc;
+  }
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (keys[i] != NULL)
+      order.push_back(i);
+  }
+
+  std::sort(order.begin(), order.end(), KeyIndexCompare(txn, dbi, keys));
+
+  for (std::vector< size_t >::iterator it = order.begin()
+      ; it != order.end()
+      ; ++it) {
+
+    MDB_val key = *keys[*it];
+    rc = mdb_cursor_get(cursor, &key, &val, MDB_SET);
+    if (rc == MDB_NOTFOUND)
+      continue;
+    if (rc || (rc = CopyValue(values[*it], val)))
+      break;
+  }
+
+  ReleaseCursor(txn, cursor, snapshot);
+  UnlockMap();
+
+  return rc == MDB_NOTFOUND ? 0 : rc;
+}
+
+// only cursors on the main db are pooled, a snapshot keeps its own
+int Database::NewCursor (
+      MDB_dbi dbi
+    , MDB_txn **txn
+    , MDB_cursor **cursor
+    , leveldown::Snapshot* snapshot) {
+
+  int rc;
+
+  rc = AcquireReadTxn(txn, snapshot);
   if (rc)
     return rc;
 
+  if (snapshot != NULL) {
+    rc = snapshot->OpenCursor(dbi, cursor);
+    if (rc)
+      ReleaseReadTxn(*txn, snapshot);
+    return rc;
+  }
+
+  *cursor = NULL;
+
+  if (poolReads && dbi == this->dbi) {
+    uv_mutex_lock(&readPoolMutex);
+    if (!cursorPool.empty()) {
+      *cursor = cursorPool.back();
+      cursorPool.pop_back();
+    }
+    uv_mutex_unlock(&readPoolMutex);
+
+    if (*cursor != NULL) {
+      rc = mdb_cursor_renew(*txn, *cursor);
+      if (rc == 0)
+        return rc;
+      mdb_cursor_close(*cursor);
+    }
+  }
+
   rc = mdb_cursor_open(*txn, dbi, cursor);
   if (rc) {
-    mdb_txn_abort(*txn);
+    ReleaseReadTxn(*txn);
     return rc;
   }
 
   return rc;
 }
 
-uint64_t Database::ApproximateSizeFromDatabase (MDB_val* start, MDB_val* end) {
-  uint64_t size = 0;
+void Database::ReleaseCursor (
+      MDB_txn *txn
+    , MDB_cursor *cursor
+    , leveldown::Snapshot* snapshot) {
+
+  if (snapshot != NULL) {
+    snapshot->CloseCursor(cursor);
+    ReleaseReadTxn(txn, snapshot);
+    return;
+  }
+
+  if (poolReads && mdb_cursor_dbi(cursor) == dbi) {
+    uv_mutex_lock(&readPoolMutex);
+    if (cursorPool.size() < READ_POOL_MAX) {
+      cursorPool.push_back(cursor);
+      cursor = NULL;
+    }
+    uv_mutex_unlock(&readPoolMutex);
+  }
+
+  if (cursor != NULL)
+    mdb_cursor_close(cursor);
+
+  ReleaseReadTxn(txn);
+}
+
+static int SeekRange (
+    MDB_cursor* cursor
+  , MDB_val* at
+  , bool last
+  , MDB_val& key
+  , MDB_val& val
+) {
+  int rc;
+
+  if (at != NULL) {
+    key.mv_data = at->mv_data;
+    key.mv_size = at->mv_size;
+    rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
+    if (rc == MDB_NOTFOUND && last)
+      rc = mdb_cursor_get(cursor, &key, &val, MDB_LAST);
+  } else {
+    rc = mdb_cursor_get(cursor, &key, &val, last ? MDB_LAST : MDB_FIRST);
+  }
+
+  return rc;
+}
+
+/*
+ * Rather than walking the range, find where each boundary falls in the tree
+ * (see mdb_cursor_position(), proportional to the depth of the tree) and
+ * take that share of the pages in use, including overflow pages. When both
+ * boundaries land on the same leaf the range is small enough to sum
+ * exactly, in the same terms: the page bytes each entry takes up (see
+ * mdb_cursor_footprint()), so that the two are comparable. `error` is a
+ * rough bound: a leaf page's share either side.
+ */
+int Database::ApproximateSizeFromDatabase (
+    MDB_dbi dbi
+  , MDB_val* start
+  , MDB_val* end
+  , uint64_t& size
+  , bool& exact
+  , uint64_t& error
+) {
   int rc;
   MDB_txn* txn;
   MDB_cursor* cursor;
   MDB_val key;
   MDB_val val;
+  MDB_stat stat;
+  double startPos, endPos;
+  size_t startLeaf, endLeaf;
 
-  rc = NewCursor(&txn, &cursor);
+  size = 0;
+  error = 0;
+  exact = true;
 
-  if (rc != 0)
-    return size;
+  LockMap();
 
-  if (start != NULL) {
-    key.mv_data = start->mv_data;
-    key.mv_size = start->mv_size;
-    rc = mdb_cursor_get(cursor, &key, &val, MDB_SET_RANGE);
-  } else {
-    rc = mdb_cursor_get(cursor, &key, &val, MDB_FIRST);
+  rc = NewCursor(dbi, &txn, &cursor);
+
+  if (rc != 0) {
+    UnlockMap();
+    return rc;
+  }
+
+  rc = SeekRange(cursor, start, false, key, val);
+  if (rc == 0)
+    rc = mdb_cursor_position(cursor, &startPos, &startLeaf);
+
+  if (rc == 0) {
+    rc = SeekRange(cursor, end, true, key, val);
+    if (rc == 0)
+      rc = mdb_cursor_position(cursor, &endPos, &endLeaf);
+    if (rc == 0 && (end == NULL || mdb_cmp(txn, dbi, &key, end) < 0))
+      endPos = 1;
+  }
+
+  if (rc == 0 && startLeaf == endLeaf) {
+    rc = SeekRange(cursor, start, false, key, val);
+    while (rc == 0) {
+      int cmp = end != NULL ? mdb_cmp(txn, dbi, &key, end) : -1;
+      if (cmp > 0)
+        break;
+      size_t bytes;
+      rc = mdb_cursor_footprint(cursor, &bytes);
+      if (rc != 0)
+        break;
+      size += bytes;
+      if (cmp == 0)
+        break;
+      rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
+    }
+  } else if (rc == 0) {
+    rc = mdb_stat(txn, dbi, &stat);
+    if (rc == 0 && endPos > startPos) {
+      double pages = (double)(stat.ms_leaf_pages + stat.ms_overflow_pages);
+      double bytes = pages * stat.ms_psize;
+      size = (uint64_t)((endPos - startPos) * bytes);
+      error = (uint64_t)(2 * bytes / (stat.ms_leaf_pages ? stat.ms_leaf_pages : 1));
+      exact = false;
+    }
   }
 
+  ReleaseCursor(txn, cursor);
+  UnlockMap();
+
+  return rc == MDB_NOTFOUND ? 0 : rc;
+}
+
+/*
+ * One cursor walks the range, Add()ing each value where it lies in the map,
+ * nothing is copied. Sub-db names in the main db aren't values to aggregate.
+ */
+int Database::AggregateFromDatabase (
+      MDB_dbi dbi
+    , MDB_val* gt
+    , MDB_val* gte
+    , MDB_val* lt
+    , MDB_val* lte
+    , const std::vector< Filter >& filters
+    , leveldown::Aggregate& aggregate
+    , leveldown::Snapshot* snapshot) {
+
+  int rc;
+  MDB_txn* txn;
+  MDB_cursor* cursor;
+  MDB_val key;
+  MDB_val val;
+
+  LockMap();
+
+  rc = NewCursor(dbi, &txn, &cursor, snapshot);
+  if (rc) {
+    UnlockMap();
+    return rc;
+  }
+
+  rc = SeekRange(cursor, gte != NULL ? gte : gt, false, key, val);
+
   while (rc == 0) {
-    size += key.mv_size;
-    size += val.mv_size;
-    if (end != NULL && mdb_cmp(txn, dbi, &key, end) >= 0)
+    if ((lt != NULL && mdb_cmp(txn, dbi, &key, lt) >= 0)
+        || (lte != NULL && mdb_cmp(txn, dbi, &key, lte) > 0))
       break;
+
+    if ((gt == NULL || mdb_cmp(txn, dbi, &key, gt) > 0)
+        && (gte == NULL || mdb_cmp(txn, dbi, &key, gte) >= 0)
+        && !mdb_cursor_is_db(cursor)
+        && (filters.empty() || MatchesAll(filters, key, val)))
+      aggregate.Add(val);
+
     rc = mdb_cursor_get(cursor, &key, &val, MDB_NEXT);
   }
 
-  mdb_cursor_close(cursor);
-  mdb_txn_abort(txn);
+  ReleaseCursor(txn, cursor, snapshot);
+  UnlockMap();
 
-  return size;
+  return rc == MDB_NOTFOUND ? 0 : rc;
 }
 
 int Database::BackupDatabase (char* path) {
@@ -347,7 +1068,11 @@ int Database::BackupDatabase (char* path) {
       return rc;
   }
 
-  return mdb_env_copy(env, path);
+  LockMap();
+  rc = mdb_env_copy(env, path);
+  UnlockMap();
+
+  return rc;
 }
 
 void Database::GetPropertyFromDatabase (
@@ -361,13 +1086,22 @@ void Database::GetPropertyFromDatabase (
     return;
   }
 
-  MDB_envinfo info;
-  int ret = mdb_env_info(env, &info);
+  // both are read out of the map, which a resize waiting on long reads
+  // may be about to move: rather than have the main thread wait on it,
+  // the last ones read are used
+  if (TryLockMap()) {
+    envInfoRc = mdb_env_info(env, &envInfo);
+    envStatRc = mdb_env_stat(env, &envStat);
+    UnlockMap();
+  }
+
+  const MDB_envinfo& info = envInfo;
+  const MDB_stat& stat = envStat;
 
   std::string s;
   std::stringstream ss;
 
-  if (ret != 0)
+  if (envInfoRc != 0)
     return;
 
   if (strcmp(property, "mdb.mapsize") == 0) {
@@ -405,52 +1139,463 @@ void Database::GetPropertyFromDatabase (
     return;
   }
 
-  MDB_stat stat;
-  ret = mdb_env_stat(env, &stat);
+  if (strcmp(property, "mdb.map_resizes") == 0) {
+    ss << mapGeneration.load();
+    ss >> s;
+    value->assign(s.data(), s.size());
+    return;
+  }
+
+  if (envStatRc != 0)
+    return;
+
+  if (strcmp(property, "mdb.psize") == 0) {
+    ss << stat.ms_psize;
+    ss >> s;
+    value->assign(s.data(), s.size());
+    return;
+  }
+
+  if (strcmp(property, "mdb.depth") == 0) {
+    ss << stat.ms_depth;
+    ss >> s;
+    value->assign(s.data(), s.size());
+    return;
+  }
+
+  if (strcmp(property, "mdb.branch_pages") == 0) {
+    ss << (long long)stat.ms_branch_pages;
+    ss >> s;
+    value->assign(s.data(), s.size());
+    return;
+  }
+
+  if (strcmp(property, "mdb.leaf_pages") == 0) {
+    ss << (long long)stat.ms_leaf_pages;
+    ss >> s;
+    value->assign(s.data(), s.size());
+    return;
+  }
+
+  if (strcmp(property, "mdb.overflow_pages") == 0) {
+    ss << (long long)stat.ms_overflow_pages;
+    ss >> s;
+    value->assign(s.data(), s.size());
+    return;
+  }
+
+  if (strcmp(property, "mdb.entries") == 0) {
+    ss << (long long)stat.ms_entries;
+    ss >> s;
+    value->assign(s.data(), s.size());
+    return;
+  }
+}
+
+/* Writer thread *****************************/
+
+/*
+ * All writes are funnelled through a single thread owned by the Database
+ * rather than the libuv threadpool, where they'd only sit blocked on the
+ * LMDB writer lock while reads starve behind them. Requests are pushed
+ * onto a lock-free queue from the main thread; the writer drains it and
+ * folds everything it finds into a single txn (group commit) then hands
+ * the requests back to the main thread via `completeAsync`.
+ */
+
+void Database::WriterMain (void* arg) {
+  static_cast<Database*>(arg)->WriterLoop();
+}
+
+void Database::WriterLoop () {
+  while (true) {
+    uv_sem_wait(&writerSem);
+
+    WriteRequest* group = NULL;
+    WriteRequest* last = NULL;
+    int count = 0;
+
+    while (count < WRITE_GROUP_MAX) {
+      WriteRequest* request = heldWrite;
+      heldWrite = NULL;
+
+      if (request == NULL) {
+        QueueNode* node = writeQueue.Pop();
+        if (node == NULL)
+          break;
+        request = static_cast<WriteRequest*>(node);
+      }
+
+      // a request that has to be alone waits for the next group
+      if (request->alone && count > 0) {
+        heldWrite = request;
+        break;
+      }
+
+      request->rc = 0;
+      request->next = NULL;
+      if (last == NULL)
+        group = request;
+      else
+        last->next = request;
+      last = request;
+      count++;
+
+      if (request->alone)
+        break;
+    }
+
+    if (group == NULL) {
+      if (writerStop.load())
+        break;
+      continue;
+    }
+
+    CommitGroup(group);
+
+    // a request with more to do goes to the back of the queue for another
+    // txn, letting anything queued meanwhile in ahead of it
+    if (group->alone && group->rc == 0 && group->Continue()) {
+      if (deferredSync) {
+        uv_mutex_lock(&flushMutex);
+        unsyncedBytes += group->bytes;
+        if (unsyncedBytes >= flushBytes)
+          uv_cond_signal(&flushCond);
+        uv_mutex_unlock(&flushMutex);
+      }
+      writeQueue.Push(group);
+      uv_sem_post(&writerSem);
+      continue;
+    }
+
+    bool flush = false;
+
+    if (deferredSync) {
+      uv_mutex_lock(&flushMutex);
+      while (group != NULL) {
+        WriteRequest* next = group->next;
+        if (group->rc == 0) {
+          unsyncedBytes += group->bytes;
+          if (group->durable) {
+            group->next = NULL;
+            if (syncTail == NULL)
+              syncHead = group;
+            else
+              syncTail->next = group;
+            syncTail = group;
+            group = next;
+            continue;
+          }
+        }
+        completeQueue.Push(group);
+        group = next;
+      }
+      flush = unsyncedBytes >= flushBytes;
+      uv_mutex_unlock(&flushMutex);
+    }
+
+    while (group != NULL) {
+      WriteRequest* next = group->next;
+      completeQueue.Push(group);
+      group = next;
+    }
+    uv_async_send(completeAsync);
+
+    if (flush)
+      uv_cond_signal(&flushCond);
+  }
+}
+
+/*
+ * When the env is opened without full syncing (`sync: false`,
+ * `metaSync: false` or `mapAsync: true`) commits are only "visible", so
+ * this thread batches mdb_env_sync() calls, every `flushInterval` ms or as
+ * soon as `flushBytes` have been written, whichever comes first. Writes
+ * asking for `sync: true` are held back until a sync covering their commit
+ * has completed.
+ */
+
+void Database::FlusherMain (void* arg) {
+  static_cast<Database*>(arg)->FlusherLoop();
+}
+
+void Database::FlusherLoop () {
+  uv_mutex_lock(&flushMutex);
+
+  while (true) {
+    if (!flusherStop && unsyncedBytes < flushBytes)
+      uv_cond_timedwait(&flushCond, &flushMutex, flushInterval * 1000000);
+
+    WriteRequest* waiters = syncHead;
+    bool dirty = unsyncedBytes > 0 || waiters != NULL;
+    bool stop = flusherStop;
+
+    syncHead = NULL;
+    syncTail = NULL;
+    unsyncedBytes = 0;
+
+    uv_mutex_unlock(&flushMutex);
+
+    if (dirty) {
+      // everything in `waiters` committed before we took the list
+      LockMap();
+      int rc = mdb_env_sync(env, 1);
+      UnlockMap();
+
+      if (waiters != NULL) {
+        while (waiters != NULL) {
+          WriteRequest* next = waiters->next;
+          waiters->rc = rc;
+          completeQueue.Push(waiters);
+          waiters = next;
+        }
+        uv_async_send(completeAsync);
+      }
+    }
+
+    if (stop)
+      return;
+
+    uv_mutex_lock(&flushMutex);
+  }
+}
+
+void Database::CommitGroup (WriteRequest* group) {
+  int rc;
+  MDB_txn *txn;
+  WriteRequest* request;
+
+  // a write txn reads the map as much as any reader does
+  LockMap();
+
+  while (true) {
+    rc = mdb_txn_begin(env, NULL, 0, &txn);
+
+    if (rc == MDB_MAP_RESIZED && autoGrow) {
+      uint32_t generation = mapGeneration.load();
+      UnlockMap();
+      bool resized = ResizeMap(0, generation);
+      LockMap();
+      if (resized)
+        continue;
+    }
+
+    if (rc)
+      break;
+
+    for (request = group; request != NULL; request = request->next) {
+      // requests that have already failed sit out the replay
+      if (request->rc != 0)
+        continue;
+      request->rc = request->Write(txn);
+      if (request->rc != 0)
+        break;
+    }
+
+    if (request == NULL) {
+      rc = mdb_txn_commit(txn);
+      if (rc != MDB_MAP_FULL || !autoGrow)
+        break;
+    } else {
+      // a single failure mustn't take the rest of the group down with it,
+      // throw this txn away and replay everything that hasn't failed
+      mdb_txn_abort(txn);
+      if (request->rc != MDB_MAP_FULL || !autoGrow)
+        continue;
+    }
+
+    // out of room: grow the map and replay the lot, failing request
+    // included, unless the map can't grow any further
+    uint32_t generation = mapGeneration.load();
+    UnlockMap();
+    bool resized = ResizeMap(mapSize * 2, generation);
+    LockMap();
+
+    if (!resized) {
+      // a failed commit has taken its rc with it
+      if (request == NULL)
+        break;
+      continue;
+    }
+
+    if (request != NULL)
+      request->rc = 0;
+  }
+
+  UnlockMap();
+
+  if (rc == 0)
+    return;
+
+  for (request = group; request != NULL; request = request->next) {
+    if (request->rc == 0)
+      request->rc = rc;
+  }
+}
+
+/*
+ * With `autoGrow`, everything that reads the map does so holding
+ * `mapLock` shared (writer thread included) so that ResizeMap() can take
+ * it exclusively and know that nothing is looking at the map while it is
+ * moved. Txns survive a remap, cursors don't: see Iterator::Reposition().
+ */
+void Database::LockMap () {
+  if (!autoGrow)
+    return;
+
+  // a steady stream of readers mustn't starve a resize waiting on them
+  uv_mutex_lock(&mapGate);
+  uv_rwlock_rdlock(&mapLock);
+  uv_mutex_unlock(&mapGate);
+}
+
+bool Database::TryLockMap () {
+  if (!autoGrow)
+    return true;
+
+  if (uv_mutex_trylock(&mapGate) != 0)
+    return false;
+  bool locked = uv_rwlock_tryrdlock(&mapLock) == 0;
+  uv_mutex_unlock(&mapGate);
+
+  return locked;
+}
+
+void Database::UnlockMap () {
+  if (autoGrow)
+    uv_rwlock_rdunlock(&mapLock);
+}
+
+/*
+ * Remap at `size`, capped by `maxMapSize`, or at 0 to adopt a size another
+ * process has grown the map to. Called without the map lock held; false if
+ * the map couldn't be resized. Nothing happens (but true is returned) if
+ * someone else already resized it since `generation`.
+ */
+bool Database::ResizeMap (uint64_t size, uint32_t generation) {
+  bool resized = false;
+
+  uv_mutex_lock(&mapGate);
+  uv_rwlock_wrlock(&mapLock);
+
+  if (mapGeneration.load() != generation) {
+    resized = true;
+  } else if (sharedEnv->pins.load() > 0) {
+    // zero-copy Buffers point into the map as it is
+  } else if (size == 0 || maxMapSize == 0 || mapSize < maxMapSize) {
+    if (size != 0 && maxMapSize != 0 && size > maxMapSize)
+      size = maxMapSize;
+
+    if (mdb_env_set_mapsize(env, size) == 0) {
+      MDB_envinfo info;
+      mdb_env_info(env, &info);
+      mapSize = info.me_mapsize;
+      mapGeneration++;
+      resized = true;
+      if (size != 0)
+        mapResized = true;
+    }
+  }
+
+  uv_rwlock_wrunlock(&mapLock);
+  uv_mutex_unlock(&mapGate);
+
+  return resized;
+}
+
+/* Writer thread lifecycle, called in the main thread *****************/
+
+void Database::StartWriter () {
+  completeAsync = new uv_async_t;
+  uv_async_init(uv_default_loop(), completeAsync, CompleteWrites);
+  completeAsync->data = this;
+  // only keep the loop alive while there are writes in flight
+  uv_unref(reinterpret_cast<uv_handle_t*>(completeAsync));
+
+  if (deferredSync) {
+    uv_mutex_init(&flushMutex);
+    uv_cond_init(&flushCond);
+    flusherStop = false;
+    unsyncedBytes = 0;
+    syncHead = NULL;
+    syncTail = NULL;
+    uv_thread_create(&flusherThread, FlusherMain, this);
+  }
+
+  writerStop = false;
+  uv_sem_init(&writerSem, 0);
+  uv_thread_create(&writerThread, WriterMain, this);
+  writable = true;
+}
+
+static void CloseCompleteAsync (uv_handle_t* handle) {
+  delete reinterpret_cast<uv_async_t*>(handle);
+}
+
+void Database::ReleaseWriter () {
+  if (completeAsync == NULL)
+    return;
+
+  // anything the writer finished after the last async callback
+  ProcessCompletions();
+
+  uv_close(reinterpret_cast<uv_handle_t*>(completeAsync), CloseCompleteAsync);
+  completeAsync = NULL;
+  uv_sem_destroy(&writerSem);
+
+  if (deferredSync) {
+    uv_cond_destroy(&flushCond);
+    uv_mutex_destroy(&flushMutex);
+  }
+}
+
+void Database::QueueWrite (WriteRequest* request) {
+  if (pendingWrites++ == 0)
+    uv_ref(reinterpret_cast<uv_handle_t*>(completeAsync));
 
-  if (ret != 0)
-    return;
+  writeQueue.Push(request);
+  uv_sem_post(&writerSem);
+}
 
-  if (strcmp(property, "mdb.psize") == 0) {
-    ss << stat.ms_psize;
-    ss >> s;
-    value->assign(s.data(), s.size());
-    return;
-  }
+NAUV_WORK_CB(Database::CompleteWrites) {
+  static_cast<Database*>(async->data)->ProcessCompletions();
+}
 
-  if (strcmp(property, "mdb.depth") == 0) {
-    ss << stat.ms_depth;
-    ss >> s;
-    value->assign(s.data(), s.size());
-    return;
-  }
+void Database::ProcessCompletions () {
+  QueueNode* node;
 
-  if (strcmp(property, "mdb.branch_pages") == 0) {
-    ss << (long long)stat.ms_branch_pages;
-    ss >> s;
-    value->assign(s.data(), s.size());
-    return;
+  if (mapResized.exchange(false) && onMapResize != NULL) {
+    Nan::HandleScope scope;
+    v8::Local<v8::Value> argv[] = {
+      Nan::New<v8::Number>((double) mapSize)
+    };
+    onMapResize->Call(1, argv);
   }
 
-  if (strcmp(property, "mdb.leaf_pages") == 0) {
-    ss << (long long)stat.ms_leaf_pages;
-    ss >> s;
-    value->assign(s.data(), s.size());
-    return;
+  while ((node = completeQueue.Pop()) != NULL) {
+    if (--pendingWrites == 0)
+      uv_unref(reinterpret_cast<uv_handle_t*>(completeAsync));
+    static_cast<WriteRequest*>(node)->Complete();
   }
+}
 
-  if (strcmp(property, "mdb.overflow_pages") == 0) {
-    ss << (long long)stat.ms_overflow_pages;
-    ss >> s;
-    value->assign(s.data(), s.size());
+/* Called from a worker thread by CloseDatabase(), the writer drains
+ * anything already queued before it exits and the flusher then makes a
+ * final sync covering all of it */
+void Database::StopWriter () {
+  if (completeAsync == NULL)
     return;
-  }
 
-  if (strcmp(property, "mdb.entries") == 0) {
-    ss << (long long)stat.ms_entries;
-    ss >> s;
-    value->assign(s.data(), s.size());
-    return;
+  writerStop = true;
+  uv_sem_post(&writerSem);
+  uv_thread_join(&writerThread);
+
+  if (deferredSync) {
+    uv_mutex_lock(&flushMutex);
+    flusherStop = true;
+    uv_cond_signal(&flushCond);
+    uv_mutex_unlock(&flushMutex);
+    uv_thread_join(&flusherThread);
   }
 }
 
@@ -483,12 +1628,21 @@ void Database::Init () {
   Nan::SetPrototypeMethod(tpl, "close", Database::Close);
   Nan::SetPrototypeMethod(tpl, "put", Database::Put);
   Nan::SetPrototypeMethod(tpl, "get", Database::Get);
+  Nan::SetPrototypeMethod(tpl, "getRange", Database::GetRange);
+  Nan::SetPrototypeMethod(tpl, "getMany", Database::GetMany);
+  Nan::SetPrototypeMethod(tpl, "releaseBuffer", Database::ReleaseBuffer);
   Nan::SetPrototypeMethod(tpl, "del", Database::Delete);
   Nan::SetPrototypeMethod(tpl, "batch", Database::Batch);
   Nan::SetPrototypeMethod(tpl, "approximateSize", Database::ApproximateSize);
+  Nan::SetPrototypeMethod(tpl, "aggregate", Database::Aggregate);
   Nan::SetPrototypeMethod(tpl, "getProperty", Database::GetProperty);
   Nan::SetPrototypeMethod(tpl, "backup", Database::Backup);
+  Nan::SetPrototypeMethod(tpl, "subdb", Database::SubDb);
+  Nan::SetPrototypeMethod(tpl, "clear", Database::Clear);
+  Nan::SetPrototypeMethod(tpl, "drop", Database::Drop);
+  Nan::SetPrototypeMethod(tpl, "delRange", Database::DelRange);
   Nan::SetPrototypeMethod(tpl, "iterator", Database::Iterator);
+  Nan::SetPrototypeMethod(tpl, "snapshot", Database::Snapshot);
 }
 
 NAN_METHOD(Database::New) {
@@ -581,6 +1735,45 @@ NAN_METHOD(Database::Open) {
     , "noSubdir"
     , DEFAULT_NOSUBDIR
   );
+  options.flushInterval = UInt64OptionValue(
+      optionsObj
+    , "flushInterval"
+    , DEFAULT_FLUSH_INTERVAL
+  );
+  // a 0 ns wait would have the flusher spin
+  if (options.flushInterval == 0)
+    options.flushInterval = 1;
+  options.flushBytes = UInt64OptionValue(
+      optionsObj
+    , "flushBytes"
+    , DEFAULT_FLUSH_BYTES
+  );
+  options.autoGrow = BooleanOptionValue(
+      optionsObj
+    , "autoGrow"
+    , DEFAULT_AUTOGROW
+  );
+  options.maxMapSize = UInt64OptionValue(
+      optionsObj
+    , "maxMapSize"
+    , DEFAULT_MAX_MAPSIZE
+  );
+  options.maxDbs = UInt32OptionValue(
+      optionsObj
+    , "maxDbs"
+    , DEFAULT_MAXDBS
+  );
+
+  if (!optionsObj.IsEmpty()
+      && optionsObj->Has(Nan::New("onMapResize").ToLocalChecked())) {
+    v8::Local<v8::Value> onMapResize =
+        optionsObj->Get(Nan::New("onMapResize").ToLocalChecked());
+    if (onMapResize->IsFunction()) {
+      delete database->onMapResize;
+      database->onMapResize =
+          new Nan::Callback(onMapResize.As<v8::Function>());
+    }
+  }
 
   OpenWorker* worker = new OpenWorker(
       database
@@ -602,6 +1795,12 @@ NAN_METHOD(EmptyMethod) {
 NAN_METHOD(Database::Close) {
   LD_METHOD_SETUP_COMMON_ONEARG(close)
 
+  // writes already queued will still be committed before the env closes
+  database->writable = false;
+  // the env's dbis go with it, handles on them fail from here
+  database->subDbIds.clear();
+  database->subDbs.clear();
+
   CloseWorker* worker = new CloseWorker(
       database
     , new Nan::Callback(callback)
@@ -653,19 +1852,64 @@ NAN_METHOD(Database::Close) {
 NAN_METHOD(Database::Put) {
   LD_METHOD_SETUP_COMMON(put, 2, 3)
 
+  if (!database->IsWritable()) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "database is not open")
+  }
+
+  LD_DBI_OPTION(dbi, optionsObj, database->dbi)
+
   v8::Local<v8::Object> keyHandle = info[0].As<v8::Object>();
   v8::Local<v8::Object> valueHandle = info[1].As<v8::Object>();
   LD_STRING_OR_BUFFER_TO_SLICE(key, keyHandle, key);
-  LD_STRING_OR_BUFFER_TO_SLICE(value, valueHandle, value);
+
+  // putParts(), the value is only assembled in the page
+  ValueParts* parts = NULL;
+  MDB_val value;
+  if (valueHandle->IsArray()) {
+    v8::Local<v8::Array> keep;
+    value.mv_data = NULL;
+    parts = PartsFromArray(valueHandle.As<v8::Array>(), value.mv_size, keep);
+    if (parts == NULL) {
+      DisposeStringOrBufferFromSlice(keyHandle, key);
+      LD_RETURN_CALLBACK_OR_ERROR(callback, "putParts() requires each part to be a string or Buffer")
+    }
+    // what the worker persists & disposes of in place of the caller's
+    valueHandle = keep;
+  } else {
+    LD_STRING_OR_BUFFER_TO_SLICE(slice, valueHandle, value);
+    value = slice;
+  }
 
   bool sync = BooleanOptionValue(optionsObj, "sync");
+  bool append = BooleanOptionValue(optionsObj, "append");
+
+  WriteCondition condition = BooleanOptionValue(optionsObj, "ifAbsent")
+    ? WRITE_IF_ABSENT
+    : WRITE_ALWAYS;
+  v8::Local<v8::Object> expectedHandle;
+  MDB_val expected;
+  expected.mv_data = NULL;
+  expected.mv_size = 0;
+  if (!optionsObj.IsEmpty()
+      && !optionsObj->Get(Nan::New("ifEquals").ToLocalChecked())->IsUndefined()) {
+    condition = WRITE_IF_EQUALS;
+    expectedHandle = optionsObj->Get(
+        Nan::New("ifEquals").ToLocalChecked()).As<v8::Object>();
+    LD_STRING_OR_BUFFER_TO_SLICE(slice, expectedHandle, expected);
+    expected = slice;
+  }
 
   WriteWorker* worker = new WriteWorker(
       database
     , new Nan::Callback(callback)
     , key
+    , dbi
     , value
+    , parts
     , sync
+    , append
+    , condition
+    , expected
     , keyHandle
     , valueHandle
   );
@@ -673,35 +1917,207 @@ NAN_METHOD(Database::Put) {
   // persist to prevent accidental GC
   v8::Local<v8::Object> _this = info.This();
   worker->SaveToPersistent("database", _this);
-  Nan::AsyncQueueWorker(worker);
+  if (condition == WRITE_IF_EQUALS)
+    worker->SaveToPersistent("expected", expectedHandle);
+  database->QueueWrite(worker);
+}
+
+// why reads can't be given `snapshot`, or NULL if they can
+static const char* CheckSnapshot (
+      Database* database
+    , leveldown::Snapshot* snapshot) {
+  if (snapshot == NULL)
+    return NULL;
+  if (snapshot->database != database)
+    return "snapshot was taken of another database";
+  if (snapshot->IsReleased())
+    return "snapshot has been released";
+  return NULL;
 }
 
 NAN_METHOD(Database::Get) {
   LD_METHOD_SETUP_COMMON(get, 1, 2)
 
+  v8::Local<v8::Object> snapshotHandle;
+  leveldown::Snapshot* snapshot =
+      SnapshotOptionValue(optionsObj, snapshotHandle);
+  const char* snapshotError = CheckSnapshot(database, snapshot);
+  if (snapshotError != NULL) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, snapshotError)
+  }
+
+  LD_DBI_OPTION(dbi, optionsObj, database->dbi)
+
   v8::Local<v8::Object> keyHandle = info[0].As<v8::Object>();
   LD_STRING_OR_BUFFER_TO_SLICE(key, keyHandle, key);
 
   bool asBuffer = BooleanOptionValue(optionsObj, "asBuffer", true);
   bool fillCache = BooleanOptionValue(optionsObj, "fillCache", true);
+  bool zeroCopy = BooleanOptionValue(optionsObj, "zeroCopy");
 
   ReadWorker* worker = new ReadWorker(
       database
     , new Nan::Callback(callback)
     , key
+    , dbi
     , asBuffer
     , fillCache
+    // a pinned txn is released from the main thread, as with pooling
+    // that needs MDB_NOTLS; reads on a snapshot are copied out of its txn,
+    // & so is everything with MDB_WRITEMAP, see OpenDatabase()
+    , asBuffer && zeroCopy && database->ZeroCopies() && snapshot == NULL
+    , false
+    , 0
+    , 0
+    , snapshot
+    , keyHandle
+  );
+  // persist to prevent accidental GC
+  v8::Local<v8::Object> _this = info.This();
+  worker->SaveToPersistent("database", _this);
+  if (snapshot != NULL)
+    worker->SaveToPersistent("snapshot", snapshotHandle);
+  Nan::AsyncQueueWorker(worker);
+}
+
+NAN_METHOD(Database::GetRange) {
+  LD_METHOD_SETUP_COMMON(getRange, 3, 4)
+
+  v8::Local<v8::Object> snapshotHandle;
+  leveldown::Snapshot* snapshot =
+      SnapshotOptionValue(optionsObj, snapshotHandle);
+  const char* snapshotError = CheckSnapshot(database, snapshot);
+  if (snapshotError != NULL) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, snapshotError)
+  }
+
+  LD_DBI_OPTION(dbi, optionsObj, database->dbi)
+
+  v8::Local<v8::Object> keyHandle = info[0].As<v8::Object>();
+  LD_STRING_OR_BUFFER_TO_SLICE(key, keyHandle, key);
+
+  uint64_t offset = info[1]->IsNumber()
+    ? (uint64_t)info[1]->NumberValue()
+    : 0;
+  // up to the end of the value unless given
+  uint64_t length = info[2]->IsNumber()
+    ? (uint64_t)info[2]->NumberValue()
+    : UINT64_MAX;
+
+  bool asBuffer = BooleanOptionValue(optionsObj, "asBuffer", true);
+  bool zeroCopy = BooleanOptionValue(optionsObj, "zeroCopy");
+
+  ReadWorker* worker = new ReadWorker(
+      database
+    , new Nan::Callback(callback)
+    , key
+    , dbi
+    , asBuffer
+    , true
+    , asBuffer && zeroCopy && database->ZeroCopies() && snapshot == NULL
+    , true
+    , offset
+    , length
+    , snapshot
     , keyHandle
   );
   // persist to prevent accidental GC
   v8::Local<v8::Object> _this = info.This();
   worker->SaveToPersistent("database", _this);
+  if (snapshot != NULL)
+    worker->SaveToPersistent("snapshot", snapshotHandle);
+  Nan::AsyncQueueWorker(worker);
+}
+
+/*
+ * Lets go of what a zero-copy Buffer pins rather than waiting on it to be
+ * garbage collected, true if it was one still holding its txn. Reading
+ * the Buffer after is undefined.
+ */
+NAN_METHOD(Database::ReleaseBuffer) {
+  bool released = false;
+
+  if (info.Length() > 0 && node::Buffer::HasInstance(info[0])) {
+    const char* data = node::Buffer::Data(info[0]);
+    size_t size = node::Buffer::Length(info[0]);
+
+    std::pair<
+        std::multimap< const char*, PinnedRead* >::iterator
+      , std::multimap< const char*, PinnedRead* >::iterator
+    > range = pinnedBuffers.equal_range(data);
+    for (std::multimap< const char*, PinnedRead* >::iterator it = range.first
+        ; it != range.second
+        ; ++it) {
+      if (it->second->size == size) {
+        // Buffers on the same data pin it alike, any of them will do
+        Unpin(it->second);
+        released = true;
+        break;
+      }
+    }
+  }
+
+  info.GetReturnValue().Set(Nan::New<v8::Boolean>(released));
+}
+
+NAN_METHOD(Database::GetMany) {
+  LD_METHOD_SETUP_COMMON(getMany, 1, 2)
+
+  if (!info[0]->IsArray()) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "getMany() requires an array of keys")
+  }
+
+  v8::Local<v8::Object> snapshotHandle;
+  leveldown::Snapshot* snapshot =
+      SnapshotOptionValue(optionsObj, snapshotHandle);
+  const char* snapshotError = CheckSnapshot(database, snapshot);
+  if (snapshotError != NULL) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, snapshotError)
+  }
+
+  LD_DBI_OPTION(dbi, optionsObj, database->dbi)
+
+  v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(info[0]);
+  std::vector< MDB_val* >* keys = new std::vector< MDB_val* >;
+
+  for (unsigned int i = 0; i < array->Length(); i++) {
+    v8::Local<v8::Value> keyBuffer = array->Get(i);
+    MDB_val* key = NULL;
+
+    LD_STRING_OR_BUFFER_TO_COPY(key, keyBuffer, key)
+
+    keys->push_back(key);
+  }
+
+  bool asBuffer = BooleanOptionValue(optionsObj, "asBuffer", true);
+  bool sort = BooleanOptionValue(optionsObj, "sort");
+
+  GetManyWorker* worker = new GetManyWorker(
+      database
+    , new Nan::Callback(callback)
+    , dbi
+    , keys
+    , asBuffer
+    , sort
+    , snapshot
+  );
+  // persist to prevent accidental GC
+  v8::Local<v8::Object> _this = info.This();
+  worker->SaveToPersistent("database", _this);
+  if (snapshot != NULL)
+    worker->SaveToPersistent("snapshot", snapshotHandle);
   Nan::AsyncQueueWorker(worker);
 }
 
 NAN_METHOD(Database::Delete) {
   LD_METHOD_SETUP_COMMON(del, 1, 2)
 
+  if (!database->IsWritable()) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "database is not open")
+  }
+
+  LD_DBI_OPTION(dbi, optionsObj, database->dbi)
+
   v8::Local<v8::Object> keyHandle = info[0].As<v8::Object>();
   LD_STRING_OR_BUFFER_TO_SLICE(key, keyHandle, key);
 
@@ -711,13 +2127,14 @@ NAN_METHOD(Database::Delete) {
       database
     , new Nan::Callback(callback)
     , key
+    , dbi
     , sync
     , keyHandle
   );
   // persist to prevent accidental GC
   v8::Local<v8::Object> _this = info.This();
   worker->SaveToPersistent("database", _this);
-  Nan::AsyncQueueWorker(worker);
+  database->QueueWrite(worker);
 }
 
 NAN_METHOD(Database::Batch) {
@@ -732,36 +2149,147 @@ NAN_METHOD(Database::Batch) {
 
   LD_METHOD_SETUP_COMMON(batch, 1, 2)
 
+  if (!database->IsWritable()) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "database is not open")
+  }
+
+  LD_DBI_OPTION(defaultDbi, optionsObj, database->dbi)
+
   bool sync = BooleanOptionValue(optionsObj, "sync");
+  bool append = BooleanOptionValue(optionsObj, "append");
+  size_t commitBytes = UInt64OptionValue(
+      optionsObj
+    , "commitBytes"
+    , append ? DEFAULT_APPEND_COMMIT_BYTES : 0
+  );
+
+  if (node::Buffer::HasInstance(info[0])) {
+    // packed, see packed-batch.js; checked in full before it's queued so
+    // a bad Buffer can't leave a batch half written
+    const char* data = node::Buffer::Data(info[0]);
+    size_t size = node::Buffer::Length(info[0]);
+    const char* from = data;
+    PackedOp op;
+
+    while (from != NULL && from < data + size)
+      from = ReadPackedOp(from, data + size, op);
+
+    if (from == NULL) {
+      LD_RETURN_CALLBACK_OR_ERROR(callback, "batch() was given a malformed packed batch")
+    }
+
+    if (size == 0) {
+      LD_RUN_CALLBACK(callback, 0, NULL);
+      return;
+    }
+
+    // a copy, the Buffer is still JS's to change (or write again) while
+    // this waits on the writer thread
+    char* copy = (char*)malloc(size);
+    if (copy == NULL) {
+      LD_RETURN_CALLBACK_OR_ERROR(callback, "batch() couldn't copy a packed batch")
+    }
+    memcpy(copy, data, size);
+
+    PackedBatchWorker* worker = new PackedBatchWorker(
+        database
+      , new Nan::Callback(callback)
+      , copy
+      , size
+      , defaultDbi
+      , sync
+      , append
+      , commitBytes
+    );
+    // persist to prevent accidental GC
+    v8::Local<v8::Object> _this = info.This();
+    worker->SaveToPersistent("database", _this);
+    database->QueueWrite(worker);
+    return;
+  }
 
   v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(info[0]);
 
-  WriteBatch* batch = new WriteBatch(database, sync);
+  WriteBatch* batch = new WriteBatch(
+      database
+    , sync
+    , defaultDbi
+    , append
+    , commitBytes
+  );
+
+  v8::Local<v8::String> keyName = Nan::New("key").ToLocalChecked();
+  v8::Local<v8::String> valueName = Nan::New("value").ToLocalChecked();
+  v8::Local<v8::String> typeName = Nan::New("type").ToLocalChecked();
+  v8::Local<v8::String> delType = Nan::New("del").ToLocalChecked();
+  v8::Local<v8::String> putType = Nan::New("put").ToLocalChecked();
+  static const BatchOp::Type mergeTypes[] = {
+      BatchOp::ADD
+    , BatchOp::APPEND
+    , BatchOp::MAX
+    , BatchOp::MIN
+    , BatchOp::BITOR
+  };
+  v8::Local<v8::String> mergeNames[] = {
+      Nan::New("add").ToLocalChecked()
+    , Nan::New("append").ToLocalChecked()
+    , Nan::New("max").ToLocalChecked()
+    , Nan::New("min").ToLocalChecked()
+    , Nan::New("bitor").ToLocalChecked()
+  };
+  v8::Local<v8::String> ifAbsentName = Nan::New("ifAbsent").ToLocalChecked();
+  v8::Local<v8::String> ifEqualsName = Nan::New("ifEquals").ToLocalChecked();
 
   for (unsigned int i = 0; i < array->Length(); i++) {
     if (!array->Get(i)->IsObject())
       continue;
 
     v8::Local<v8::Object> obj = v8::Local<v8::Object>::Cast(array->Get(i));
-    v8::Local<v8::Object> keyBuffer =
-      obj->Get(Nan::New("key").ToLocalChecked()).As<v8::Object>();
-    v8::Local<v8::Value> type = obj->Get(Nan::New("type").ToLocalChecked());
-
-    if (type->StrictEquals(Nan::New("del").ToLocalChecked())) {
-      LD_STRING_OR_BUFFER_TO_SLICE(key, keyBuffer, key)
-
-      batch->Delete(keyBuffer, key);
-    } else if (type->StrictEquals(Nan::New("put").ToLocalChecked())) {
-      v8::Local<v8::Object> valueBuffer =
-        obj->Get(Nan::New("value").ToLocalChecked()).As<v8::Object>();
+    v8::Local<v8::Value> type = obj->Get(typeName);
+    // ops can each target a different sub-db, all in the one txn
+    MDB_dbi dbi;
+    if (!database->ResolveDbi(SubDbOptionValue(obj), defaultDbi, dbi)) {
+      delete batch;
+      LD_RETURN_CALLBACK_OR_ERROR(callback, "sub-database has been dropped")
+    }
 
-      LD_STRING_OR_BUFFER_TO_SLICE(key, keyBuffer, key)
-      LD_STRING_OR_BUFFER_TO_SLICE(value, valueBuffer, value)
-      batch->Put(keyBuffer, key, valueBuffer, value);
+    v8::Local<v8::Value> expected = obj->Get(ifEqualsName);
+    WriteCondition condition = !expected->IsUndefined()
+      ? WRITE_IF_EQUALS
+      : obj->Get(ifAbsentName)->BooleanValue()
+        ? WRITE_IF_ABSENT
+        : WRITE_ALWAYS;
+
+    if (type->StrictEquals(delType)) {
+      // a del only ever happens to a key that's there
+      if (condition == WRITE_IF_ABSENT)
+        condition = WRITE_ALWAYS;
+      batch->Delete(obj->Get(keyName), dbi, condition, expected);
+    } else if (type->StrictEquals(putType)) {
+      batch->Put(obj->Get(keyName), obj->Get(valueName), dbi, condition, expected);
+    } else {
+      // the merge ops, read-modify-write in the txn
+      for (size_t m = 0; m < sizeof(mergeTypes) / sizeof(mergeTypes[0]); m++) {
+        if (type->StrictEquals(mergeNames[m])) {
+          batch->Merge(mergeTypes[m], obj->Get(keyName), obj->Get(valueName), dbi);
+          break;
+        }
+      }
     }
   }
 
-  batch->Write(callback);
+  if (batch->operations.size() == 0) {
+    delete batch;
+    LD_RUN_CALLBACK(callback, 0, NULL);
+    return;
+  }
+
+  BatchWriteWorker* worker =
+      new BatchWriteWorker(batch, new Nan::Callback(callback), true);
+  // persist to prevent accidental GC
+  v8::Local<v8::Object> _this = info.This();
+  worker->SaveToPersistent("database", _this);
+  database->QueueWrite(worker);
 }
 
 NAN_METHOD(Database::ApproximateSize) {
@@ -770,7 +2298,9 @@ NAN_METHOD(Database::ApproximateSize) {
   MDB_val* start = NULL;
   MDB_val* end = NULL;
 
-  LD_METHOD_SETUP_COMMON(approximateSize, -1, 2)
+  LD_METHOD_SETUP_COMMON(approximateSize, 2, 3)
+
+  LD_DBI_OPTION(dbi, optionsObj, database->dbi)
 
   LD_STRING_OR_BUFFER_TO_COPY(start, startBuffer, start)
   LD_STRING_OR_BUFFER_TO_COPY(end, endBuffer, end)
@@ -778,6 +2308,7 @@ NAN_METHOD(Database::ApproximateSize) {
   ApproximateSizeWorker* worker = new ApproximateSizeWorker(
       database
     , new Nan::Callback(callback)
+    , dbi
     , start
     , end
   );
@@ -804,6 +2335,202 @@ NAN_METHOD(Database::Backup) {
   Nan::AsyncQueueWorker(worker);
 }
 
+NAN_METHOD(Database::SubDb) {
+  Database* database = Nan::ObjectWrap::Unwrap<Database>(info.This());
+
+  if (info.Length() == 0 || !info[0]->IsString()) {
+    return Nan::ThrowError("subdb() requires a name argument");
+  }
+
+  Nan::Utf8String name(info[0]);
+
+  v8::Local<v8::Object> optionsObj;
+  if (info.Length() > 1 && info[1]->IsObject()) {
+    optionsObj = info[1].As<v8::Object>();
+  }
+
+  unsigned int flags = 0;
+  if (BooleanOptionValue(optionsObj, "create", true))
+    flags |= MDB_CREATE;
+  if (BooleanOptionValue(optionsObj, "reverseKey"))
+    flags |= MDB_REVERSEKEY;
+
+  if (info.Length() > 2 && info[2]->IsFunction()) {
+    v8::Local<v8::Function> callback = info[2].As<v8::Function>();
+    if (database->sharedEnv == NULL) {
+      LD_RETURN_CALLBACK_OR_ERROR(callback, "database is not open")
+    }
+
+    // opened on the threadpool, creating one waits on the writer
+    SubDbWorker* worker = new SubDbWorker(
+        database
+      , new Nan::Callback(callback)
+      , *name
+      , flags
+    );
+    // persist to prevent accidental GC
+    v8::Local<v8::Object> _this = info.This();
+    worker->SaveToPersistent("database", _this);
+    Nan::AsyncQueueWorker(worker);
+    return;
+  }
+
+  MDB_dbi dbi;
+  int rc = database->OpenSubDatabase(
+      database->sharedEnv
+    , *name
+    , flags
+    , &dbi
+  );
+
+  if (rc != 0) {
+    return Nan::ThrowError(mdb_strerror(rc));
+  }
+
+  // the handle's id, see Database::subDbs
+  info.GetReturnValue().Set(Nan::New<v8::Uint32>(
+      database->RegisterSubDb(*name, dbi)));
+}
+
+NAN_METHOD(Database::Clear) {
+  LD_METHOD_SETUP_COMMON(clear, 0, 1)
+
+  if (!database->IsWritable()) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "database is not open")
+  }
+
+  LD_DBI_OPTION(dbi, optionsObj, database->dbi)
+
+  ClearWorker* worker = new ClearWorker(
+      database
+    , new Nan::Callback(callback)
+    , dbi
+    , BooleanOptionValue(optionsObj, "sync")
+  );
+  // persist to prevent accidental GC
+  v8::Local<v8::Object> _this = info.This();
+  worker->SaveToPersistent("database", _this);
+  database->QueueWrite(worker);
+}
+
+NAN_METHOD(Database::Drop) {
+  LD_METHOD_SETUP_COMMON(drop, 0, 1)
+
+  if (!database->IsWritable()) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "database is not open")
+  }
+
+  uint32_t id = SubDbOptionValue(optionsObj);
+  LD_DBI_OPTION(dbi, optionsObj, database->dbi)
+
+  if (id == 0) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "drop() requires a sub-database")
+  }
+
+  // every handle on it fails from here, writes already queued go first
+  database->ForgetSubDb(id);
+
+  ClearWorker* worker = new ClearWorker(
+      database
+    , new Nan::Callback(callback)
+    , dbi
+    , BooleanOptionValue(optionsObj, "sync")
+  );
+  // persist to prevent accidental GC
+  v8::Local<v8::Object> _this = info.This();
+  worker->SaveToPersistent("database", _this);
+  database->QueueWrite(worker);
+}
+
+// a copy of the non-empty string or Buffer at `options[name]`, or NULL
+static MDB_val* RangeOptionValue (v8::Local<v8::Object> options,
+                                  const char* name) {
+  MDB_val* bound = NULL;
+
+  if (options.IsEmpty() || !options->Has(Nan::New(name).ToLocalChecked()))
+    return NULL;
+
+  v8::Local<v8::Value> boundBuffer =
+    options->Get(Nan::New(name).ToLocalChecked());
+
+  if (node::Buffer::HasInstance(boundBuffer) || boundBuffer->IsString()) {
+    LD_STRING_OR_BUFFER_TO_COPY(bound, boundBuffer, bound)
+  }
+
+  return bound;
+}
+
+NAN_METHOD(Database::DelRange) {
+  LD_METHOD_SETUP_COMMON(delRange, 0, 1)
+
+  if (!database->IsWritable()) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "database is not open")
+  }
+
+  LD_DBI_OPTION(dbi, optionsObj, database->dbi)
+
+  DelRangeWorker* worker = new DelRangeWorker(
+      database
+    , new Nan::Callback(callback)
+    , dbi
+    , RangeOptionValue(optionsObj, "gt")
+    , RangeOptionValue(optionsObj, "gte")
+    , RangeOptionValue(optionsObj, "lt")
+    , RangeOptionValue(optionsObj, "lte")
+    , UInt32OptionValue(optionsObj, "chunkSize", DEFAULT_DELRANGE_CHUNK)
+    , BooleanOptionValue(optionsObj, "sync")
+  );
+  // persist to prevent accidental GC
+  v8::Local<v8::Object> _this = info.This();
+  worker->SaveToPersistent("database", _this);
+  database->QueueWrite(worker);
+}
+
+NAN_METHOD(Database::Aggregate) {
+  LD_METHOD_SETUP_COMMON(aggregate, 0, 1)
+
+  leveldown::Aggregate aggregate;
+  const char* error = ParseAggregate(optionsObj, aggregate);
+  if (error != NULL) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, error)
+  }
+
+  std::vector< Filter > filters;
+  error = ParseFilters(optionsObj, &filters);
+  if (error != NULL) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, error)
+  }
+
+  v8::Local<v8::Object> snapshotHandle;
+  leveldown::Snapshot* snapshot =
+      SnapshotOptionValue(optionsObj, snapshotHandle);
+  const char* snapshotError = CheckSnapshot(database, snapshot);
+  if (snapshotError != NULL) {
+    LD_RETURN_CALLBACK_OR_ERROR(callback, snapshotError)
+  }
+
+  LD_DBI_OPTION(dbi, optionsObj, database->dbi)
+
+  AggregateWorker* worker = new AggregateWorker(
+      database
+    , new Nan::Callback(callback)
+    , dbi
+    , RangeOptionValue(optionsObj, "gt")
+    , RangeOptionValue(optionsObj, "gte")
+    , RangeOptionValue(optionsObj, "lt")
+    , RangeOptionValue(optionsObj, "lte")
+    , filters
+    , aggregate
+    , snapshot
+  );
+  // persist to prevent accidental GC
+  v8::Local<v8::Object> _this = info.This();
+  worker->SaveToPersistent("database", _this);
+  if (snapshot != NULL)
+    worker->SaveToPersistent("snapshot", snapshotHandle);
+  Nan::AsyncQueueWorker(worker);
+}
+
 NAN_METHOD(Database::GetProperty) {
   v8::Local<v8::Value> propertyBuffer = info[0].As<v8::Object>();
   Nan::Utf8String property(propertyBuffer);
@@ -827,6 +2554,22 @@ NAN_METHOD(Database::Iterator) {
     optionsObj = v8::Local<v8::Object>::Cast(info[0]);
   }
 
+  v8::Local<v8::Object> snapshotHandle;
+  const char* snapshotError = CheckSnapshot(
+      database
+    , SnapshotOptionValue(optionsObj, snapshotHandle)
+  );
+  if (snapshotError != NULL)
+    return Nan::ThrowError(snapshotError);
+
+  const char* filterError = ParseFilters(optionsObj, NULL);
+  if (filterError != NULL)
+    return Nan::ThrowError(filterError);
+
+  MDB_dbi dbi;
+  if (!database->ResolveDbi(SubDbOptionValue(optionsObj), database->dbi, dbi))
+    return Nan::ThrowError("sub-database has been dropped");
+
   // each iterator gets a unique id for this Database, so we can
   // easily store & lookup on our `iterators` map
   uint32_t id = database->currentIteratorId++;
@@ -859,4 +2602,17 @@ NAN_METHOD(Database::Iterator) {
   info.GetReturnValue().Set(iteratorHandle);
 }
 
+NAN_METHOD(Database::Snapshot) {
+  Database* database = Nan::ObjectWrap::Unwrap<Database>(info.This());
+
+  if (database->sharedEnv == NULL)
+    return Nan::ThrowError("snapshot() requires an open database");
+
+  // reads on it happen on any thread, which needs MDB_NOTLS
+  if (!database->poolReads)
+    return Nan::ThrowError("snapshot() can't be used with `notls`");
+
+  info.GetReturnValue().Set(leveldown::Snapshot::NewInstance(info.This()));
+}
+
 } // namespace leveldown
@@ -6,6 +6,7 @@
 #ifndef LD_DATABASE_H
 #define LD_DATABASE_H
 
+#include <string.h>
 #include <map>
 #include <vector>
 #include <node.h>
@@ -13,6 +14,7 @@
 
 #include "leveldown.h"
 #include "iterator.h"
+#include "mpsc_queue.h"
 
 namespace leveldown {
 
@@ -26,6 +28,17 @@ namespace leveldown {
 #define DEFAULT_FIXEDMAP false
 #define DEFAULT_NOTLS false
 #define DEFAULT_NOSUBDIR false
+#define DEFAULT_FLUSH_INTERVAL 100 // ms
+#define DEFAULT_FLUSH_BYTES 16 << 20 // 16 MB
+#define WRITE_GROUP_MAX 1024 // requests folded into a single write txn
+#define READ_POOL_MAX 16 // reset read txns & cursors kept for reuse
+#define DEFAULT_AUTOGROW false
+#define DEFAULT_MAX_MAPSIZE 0 // no limit
+#define DEFAULT_MAXDBS 0 // no named sub-databases
+#define DEFAULT_DELRANGE_CHUNK 10000 // entries delRange() deletes per txn
+#define DEFAULT_APPEND_COMMIT_BYTES 64 << 20 // 64 MB per txn, append batches
+#define ARENA_POOL_MAX 4 // batch arenas kept for reuse
+#define ARENA_POOL_CAPACITY_MAX 16 << 20 // 16 MB, bigger arenas are freed
 
 typedef struct OpenOptions {
   bool     createIfMissing;
@@ -40,10 +53,56 @@ typedef struct OpenOptions {
   bool     fixedMap;
   bool     notls;
   bool     noSubdir;
+  uint64_t flushInterval;
+  uint64_t flushBytes;
+  bool     autoGrow;
+  uint64_t maxMapSize;
+  uint32_t maxDbs;
 } OpenOptions;
 
 NAN_METHOD(LevelDOWN);
 
+struct PinnedTxn;
+
+// The env outlives its Database being closed for as long as zero-copy
+// Buffers still point into its map, see ReleaseEnv()
+struct SharedEnv {
+  MDB_env* env;
+  std::atomic<int> refs;
+  // zero-copy Buffers alive, the map can't be moved under them
+  std::atomic<int> pins;
+  // guards the below, see Database::GetPinnedFromDatabase()
+  uv_mutex_t pinMutex;
+  // the pinned txn new zero-copy reads share while it's on the latest data
+  PinnedTxn* latestPin;
+  // pinned txns open, each holding a reader slot
+  uint32_t pinnedTxns;
+};
+
+// drops a reference to the env, closing it with the last one
+void ReleaseEnv (SharedEnv* sharedEnv);
+// a snapshot's txn, see Database::BeginSnapshot()
+int BeginSnapshotTxn (MDB_env* env, MDB_txn **txn);
+
+class Snapshot;
+
+// a read txn held open for the zero-copy Buffers read from it
+struct PinnedTxn {
+  MDB_txn* txn;
+  // Buffers still pinning it, guarded by SharedEnv::pinMutex
+  uint32_t buffers;
+};
+
+// what a zero-copy Buffer pins until it is garbage collected or released
+struct PinnedRead {
+  SharedEnv* sharedEnv;
+  PinnedTxn* pinned;
+  // the Buffer's data, to find it by on releaseBuffer()
+  const char* data;
+  size_t size;
+  bool released;
+};
+
 struct Reference {
   Nan::Persistent<v8::Object> handle;
   MDB_val val;
@@ -60,20 +119,172 @@ static inline void ClearReferences (std::vector<Reference *> *references) {
       ; it != references->end()
       ; ) {
     DisposeStringOrBufferFromSlice((*it)->handle, (*it)->val);
-    it = references->erase(it);
+    delete *it;
+    ++it;
   }
   delete references;
 }
 
-/* abstract */ class BatchOp {
+// a value given as an Array of Strings and Buffers, put in one piece by
+// PutParts(); Buffers are pointed at, Strings copied out
+struct ValueParts {
+  std::vector< MDB_val > parts;
+  // parts[i] is a copy of a String, ours to delete[]
+  std::vector< bool > owned;
+};
+
+static inline void DisposeParts (ValueParts* parts) {
+  for (size_t i = 0; i < parts->parts.size(); i++) {
+    if (parts->owned[i])
+      delete[] (char*)parts->parts[i].mv_data;
+  }
+  delete parts;
+}
+
+/*
+ * `keep` is set to an Array of our own holding the Buffers pointed at, for
+ * the caller to persist: the caller's Array may change (& drop them) before
+ * the write is done. Returns NULL on anything but Strings & Buffers.
+ */
+static inline ValueParts* PartsFromArray (
+      v8::Local<v8::Array> array
+    , size_t& size
+    , v8::Local<v8::Array>& keep) {
+  uint32_t length = array->Length();
+  ValueParts* parts = new ValueParts;
+  parts->parts.resize(length);
+  parts->owned.resize(length, false);
+  keep = Nan::New<v8::Array>(length);
+
+  size = 0;
+  for (uint32_t i = 0; i < length; i++) {
+    v8::Local<v8::Value> from = array->Get(i);
+    MDB_val& part = parts->parts[i];
+
+    if (node::Buffer::HasInstance(from)) {
+      part.mv_size = node::Buffer::Length(from);
+      part.mv_data = node::Buffer::Data(from);
+      keep->Set(i, from);
+    } else if (from->IsString()) {
+      v8::Local<v8::String> str = from.As<v8::String>();
+      part.mv_size = str->Utf8Length();
+      part.mv_data = new char[part.mv_size];
+      parts->owned[i] = true;
+      str->WriteUtf8(
+          (char*)part.mv_data
+        , -1
+        , NULL
+        , v8::String::NO_NULL_TERMINATION
+      );
+    } else {
+      parts->parts.resize(i);
+      DisposeParts(parts);
+      return NULL;
+    }
+    size += part.mv_size;
+  }
+
+  return parts;
+}
+
+// MDB_RESERVE the whole value in the page and copy each part straight in,
+// rather than joining the parts up first for mdb_put() to copy again
+static inline int PutParts (
+      MDB_txn* txn
+    , MDB_dbi dbi
+    , MDB_val* key
+    , const std::vector<MDB_val>& parts
+    , size_t size
+    , unsigned int flags) {
+  MDB_val value;
+  value.mv_size = size;
+  value.mv_data = NULL;
+
+  int rc = mdb_put(txn, dbi, key, &value, flags | MDB_RESERVE);
+  if (rc != 0)
+    return rc;
+
+  char* to = (char*)value.mv_data;
+  for (std::vector<MDB_val>::const_iterator it = parts.begin()
+      ; it != parts.end()
+      ; ++it) {
+    if (it->mv_size > 0)
+      memcpy(to, it->mv_data, it->mv_size);
+    to += it->mv_size;
+  }
+
+  return 0;
+}
+
+// a condition on a write, checked inside the write txn, see `ifAbsent`
+// & `ifEquals`
+enum WriteCondition { WRITE_ALWAYS, WRITE_IF_ABSENT, WRITE_IF_EQUALS };
+
+// whether the value of `key` is `expected`, a missing key never is
+static inline int ValueEquals (
+      MDB_txn* txn
+    , MDB_dbi dbi
+    , MDB_val* key
+    , const MDB_val& expected
+    , bool& equal) {
+  MDB_val current;
+
+  int rc = mdb_get(txn, dbi, key, &current);
+  if (rc == MDB_NOTFOUND) {
+    equal = false;
+    return 0;
+  }
+  if (rc == 0) {
+    equal = current.mv_size == expected.mv_size
+      && (expected.mv_size == 0
+        || memcmp(current.mv_data, expected.mv_data, expected.mv_size) == 0);
+  }
+
+  return rc;
+}
+
+// narrow `value` to at most `length` bytes from `offset`, see getRange()
+static inline void SliceValue (MDB_val& value, uint64_t offset, uint64_t length) {
+  if (offset >= value.mv_size) {
+    value.mv_data = (char*)value.mv_data + value.mv_size;
+    value.mv_size = 0;
+    return;
+  }
+  value.mv_data = (char*)value.mv_data + offset;
+  if (length < value.mv_size - offset)
+    value.mv_size = length;
+  else
+    value.mv_size -= offset;
+}
+
+/* abstract */ class WriteRequest : public QueueNode {
  public:
-  BatchOp (v8::Local<v8::Object> &keyHandle, MDB_val key);
-  virtual ~BatchOp ();
-  virtual int Execute (MDB_txn *txn, MDB_dbi dbi) =0;
+  WriteRequest ()
+    : rc(0), durable(false), alone(false), bytes(0), next(NULL) {}
+  virtual ~WriteRequest () {}
+
+  // called on the writer thread, NO V8 HERE
+  // NOTE: may be called more than once for the same request, if another
+  // request in the same group fails, the txn is aborted and the rest of
+  // the group is replayed in a fresh one
+  virtual int Write (MDB_txn *txn) =0;
 
- protected:
-  Nan::Persistent<v8::Object> persistentHandle;
-  MDB_val key;
+  // called on the writer thread once a txn including this request has
+  // committed, true to be queued again for another txn; only for `alone`
+  // requests, that can spread their work over several commits
+  virtual bool Continue () { return false; }
+
+  // called in the main thread once `rc` is final
+  virtual void Complete () =0;
+
+  int rc;
+  // don't Complete() until the commit has been flushed to disk
+  bool durable;
+  // commit in a txn of its own, for writes that can't be replayed
+  bool alone;
+  // approximate bytes this request writes, drives the flusher
+  size_t bytes;
+  WriteRequest* next;
 };
 
 class Database : public Nan::ObjectWrap {
@@ -83,16 +294,113 @@ public:
 
   md_status OpenDatabase (OpenOptions options);
   void CloseDatabase     ();
-  int PutToDatabase      (MDB_val key, MDB_val value);
-  int PutToDatabase      (std::vector< BatchOp* >* operations);
-  int GetFromDatabase    (MDB_val key, std::string& value);
-  int DeleteFromDatabase (MDB_val key);
-  int NewCursor          (MDB_txn **txn, MDB_cursor **cursor);
+  int OpenSubDatabase    (
+      SharedEnv* sharedEnv
+    , const char* name
+    , unsigned int flags
+    , MDB_dbi* dbi
+  );
+  int GetFromDatabase    (
+      MDB_dbi dbi
+    , MDB_val key
+    , MDB_val& value
+    , leveldown::Snapshot* snapshot = NULL
+  );
+  int GetRangeFromDatabase (
+      MDB_dbi dbi
+    , MDB_val key
+    , uint64_t offset
+    , uint64_t length
+    , MDB_val& value
+    , size_t& size
+    , leveldown::Snapshot* snapshot = NULL
+  );
+  int GetPinnedFromDatabase (
+      SharedEnv* sharedEnv
+    , MDB_dbi dbi
+    , MDB_val key
+    , MDB_val& value
+    , PinnedRead** pin
+  );
+  int GetManyFromDatabase (
+      MDB_dbi dbi
+    , std::vector< MDB_val* >& keys
+    , bool sort
+    , std::vector< MDB_val >& values
+    , leveldown::Snapshot* snapshot = NULL
+  );
+  int NewCursor          (
+      MDB_dbi dbi
+    , MDB_txn **txn
+    , MDB_cursor **cursor
+    , leveldown::Snapshot* snapshot = NULL
+  );
+  void ReleaseCursor     (
+      MDB_txn *txn
+    , MDB_cursor *cursor
+    , leveldown::Snapshot* snapshot = NULL
+  );
+  int AcquireReadTxn     (MDB_txn **txn, leveldown::Snapshot* snapshot = NULL);
+  void ReleaseReadTxn    (MDB_txn *txn, leveldown::Snapshot* snapshot = NULL);
+  int BeginSnapshot      (MDB_txn **txn, SharedEnv **sharedEnv);
+  void StartWriter       ();
+  void StopWriter        ();
+  void ReleaseWriter     ();
+  void QueueWrite        (WriteRequest* request);
+  bool IsWritable        () const { return writable; }
+  // called in the main thread, a reference to the env for a worker to hold
+  // (see ReleaseEnv()), NULL if not open
+  SharedEnv* AcquireEnv  () {
+    if (sharedEnv != NULL)
+      sharedEnv->refs++;
+    return sharedEnv;
+  }
+  // still open on the env a worker holds, not closed (& reopened) since
+  bool IsOpenOn          (SharedEnv* env) const {
+    return env != NULL && env == sharedEnv;
+  }
+  void LockMap           ();
+  // LockMap() without waiting, false if a resize has it or is waiting on it
+  bool TryLockMap        ();
+  void UnlockMap         ();
+  bool IsGrowable        () const { return autoGrow; }
+  // read txns aren't tied to a thread, MDB_NOTLS
+  bool PoolsReads        () const { return poolReads; }
+  // zero-copy Buffers can be handed out, see GetPinnedFromDatabase()
+  bool ZeroCopies        () const { return zeroCopy; }
+  uint32_t RegisterSubDb (const std::string& name, MDB_dbi dbi);
+  bool ResolveDbi        (uint32_t id, MDB_dbi def, MDB_dbi& dbi);
+  void ForgetSubDb       (uint32_t id);
+  uint32_t MapGeneration () const { return mapGeneration.load(); }
   void ReleaseIterator   (uint32_t id);
-  uint64_t ApproximateSizeFromDatabase (MDB_val* start, MDB_val* end);
+  int ApproximateSizeFromDatabase (
+      MDB_dbi dbi
+    , MDB_val* start
+    , MDB_val* end
+    , uint64_t& size
+    , bool& exact
+    , uint64_t& error
+  );
+  int AggregateFromDatabase (
+      MDB_dbi dbi
+    , MDB_val* gt
+    , MDB_val* gte
+    , MDB_val* lt
+    , MDB_val* lte
+    , const std::vector< Filter >& filters
+    , leveldown::Aggregate& aggregate
+    , leveldown::Snapshot* snapshot = NULL
+  );
   void GetPropertyFromDatabase (char* property, std::string* value);
   int BackupDatabase (char* path);
 
+  static v8::Local<v8::Object> NewPinnedBuffer (
+      MDB_val value
+    , PinnedRead* pin
+  );
+  static void ReleasePinned (char* data, void* hint);
+  static void Unpin (PinnedRead* pin);
+
   Database (const v8::Local<v8::Value>& from);
   ~Database ();
 
@@ -103,23 +411,115 @@ private:
   Nan::Utf8String* location;
   uint32_t currentIteratorId;
   void(*pendingCloseWorker);
+  SharedEnv* sharedEnv;
+  bool namedDbs;
+
+  /*
+   * The named dbs subdb() has opened: each name is given an id, which its
+   * handles carry rather than the dbi, & drop() forgets it so that every
+   * handle on it fails from then on. The dbi itself is never closed, LMDB
+   * can't have that while other threads may be using it, nor its slot
+   * handed to another name. Main thread only.
+   */
+  std::map< std::string, uint32_t > subDbIds;
+  std::map< uint32_t, MDB_dbi > subDbs;
+  uint32_t lastSubDbId;
 
   std::map< uint32_t, leveldown::Iterator * > iterators;
 
+  // reset read txns & their cursors, see AcquireReadTxn()
+  bool poolReads;
+  // not with MDB_WRITEMAP, a Buffer into the map would be writable
+  bool zeroCopy;
+  // pinned txns allowed open at once, see GetPinnedFromDatabase()
+  uint32_t maxPinnedTxns;
+  uv_mutex_t readPoolMutex;
+  // one txn opening dbs at a time, see OpenSubDatabase()
+  uv_mutex_t dbiMutex;
+  std::vector< MDB_txn* > txnPool;
+  std::vector< MDB_cursor* > cursorPool;
+
+  void DrainReadPool ();
+
+  // writer thread, see QueueWrite()
+  uv_thread_t writerThread;
+  uv_sem_t writerSem;
+  std::atomic<bool> writerStop;
+  MPSCQueue writeQueue;
+  MPSCQueue completeQueue;
+  WriteRequest* heldWrite;
+  uv_async_t* completeAsync;
+  uint32_t pendingWrites;
+  bool writable;
+
+  // flusher thread, only when commits don't sync, see FlusherLoop()
+  bool deferredSync;
+  uint64_t flushInterval;
+  uint64_t flushBytes;
+  uv_thread_t flusherThread;
+  uv_mutex_t flushMutex;
+  uv_cond_t flushCond;
+  bool flusherStop;
+  uint64_t unsyncedBytes;
+  WriteRequest* syncHead;
+  WriteRequest* syncTail;
+
+  // growing the map on MDB_MAP_FULL, only with `autoGrow`, see ResizeMap()
+  bool autoGrow;
+  uint64_t mapSize;
+  uint64_t maxMapSize;
+  uv_rwlock_t mapLock;
+  uv_mutex_t mapGate;
+  std::atomic<uint32_t> mapGeneration;
+  std::atomic<bool> mapResized;
+  Nan::Callback* onMapResize;
+  // the last read of the env's info & stat, see GetPropertyFromDatabase()
+  int envInfoRc;
+  MDB_envinfo envInfo;
+  int envStatRc;
+  MDB_stat envStat;
+
+  bool ResizeMap (uint64_t size, uint32_t generation);
+
+  static void WriterMain (void* arg);
+  static void FlusherMain (void* arg);
+  static NAUV_WORK_CB(CompleteWrites);
+  void WriterLoop ();
+  void FlusherLoop ();
+  void CommitGroup (WriteRequest* group);
+  void ProcessCompletions ();
+
   static NAN_METHOD(New);
   static NAN_METHOD(Open);
   static NAN_METHOD(Close);
   static NAN_METHOD(Put);
   static NAN_METHOD(Delete);
   static NAN_METHOD(Get);
+  static NAN_METHOD(GetRange);
+  static NAN_METHOD(GetMany);
+  static NAN_METHOD(ReleaseBuffer);
   static NAN_METHOD(Batch);
   static NAN_METHOD(Write);
   static NAN_METHOD(Iterator);
+  static NAN_METHOD(Snapshot);
   static NAN_METHOD(ApproximateSize);
+  static NAN_METHOD(Aggregate);
   static NAN_METHOD(GetProperty);
   static NAN_METHOD(Backup);
+  static NAN_METHOD(SubDb);
+  static NAN_METHOD(Clear);
+  static NAN_METHOD(Drop);
+  static NAN_METHOD(DelRange);
 };
 
+// sets `dbi` from the `subdb` in `options`, or `def`, for a NAN_METHOD set
+// up by LD_METHOD_SETUP_COMMON(); a dropped sub-db is an error
+#define LD_DBI_OPTION(dbi, options, def)                                       \
+  MDB_dbi dbi;                                                                 \
+  if (!database->ResolveDbi(SubDbOptionValue(options), def, dbi)) {            \
+    LD_RETURN_CALLBACK_OR_ERROR(callback, "sub-database has been dropped")     \
+  }
+
 } // namespace leveldown
 
 #endif
@@ -29,6 +29,13 @@ void OpenWorker::Execute () {
   SetStatus(database->OpenDatabase(options));
 }
 
+void OpenWorker::HandleOKCallback () {
+  Nan::HandleScope scope;
+
+  database->StartWriter();
+  callback->Call(0, NULL);
+}
+
 /** CLOSE WORKER **/
 
 CloseWorker::CloseWorker (
@@ -45,6 +52,7 @@ void CloseWorker::Execute () {
 
 void CloseWorker::WorkComplete () {
   Nan::HandleScope scope;
+  database->ReleaseWriter();
   HandleOKCallback();
   delete callback;
   callback = NULL;
@@ -56,9 +64,11 @@ IOWorker::IOWorker (
     Database *database
   , Nan::Callback *callback
   , MDB_val key
+  , MDB_dbi dbi
   , v8::Local<v8::Object> &keyHandle
 ) : AsyncWorker(database, callback)
   , key(key)
+  , dbi(dbi)
   , keyHandle(keyHandle)
 {
   Nan::HandleScope scope;
@@ -81,39 +91,186 @@ ReadWorker::ReadWorker (
     Database *database
   , Nan::Callback *callback
   , MDB_val key
+  , MDB_dbi dbi
   , bool asBuffer
   , bool fillCache
+  , bool zeroCopy
+  , bool range
+  , uint64_t offset
+  , uint64_t length
+  , Snapshot* snapshot
   , v8::Local<v8::Object> &keyHandle
-) : IOWorker(database, callback, key, keyHandle)
+) : IOWorker(database, callback, key, dbi, keyHandle)
   , asBuffer(asBuffer)
+  , zeroCopy(zeroCopy)
+  , range(range)
+  , offset(offset)
+  , length(length)
+  , size(0)
+  , pin(NULL)
+  , snapshot(snapshot)
+  // taken now, a close() can't then take the env away mid read
+  , sharedEnv(zeroCopy ? database->AcquireEnv() : NULL)
 {
   Nan::HandleScope scope;
 
   SaveToPersistent("key", keyHandle);
+  value.mv_data = NULL;
 };
 
-ReadWorker::~ReadWorker () { }
+ReadWorker::~ReadWorker () {
+  // only set if we never got as far as handing it to a Buffer
+  if (!zeroCopy)
+    free(value.mv_data);
+  if (pin != NULL)
+    Database::ReleasePinned(NULL, pin);
+  if (sharedEnv != NULL)
+    ReleaseEnv(sharedEnv);
+}
 
 void ReadWorker::Execute () {
-  SetStatus(database->GetFromDatabase(key, value));
+  if (zeroCopy && sharedEnv != NULL) {
+    int rc = database->GetPinnedFromDatabase(
+        sharedEnv
+      , dbi
+      , key
+      , value
+      , &pin
+    );
+    if (rc == 0 && range) {
+      // still a single pin, the slice keeps the whole value's txn open
+      size = value.mv_size;
+      SliceValue(value, offset, length);
+    }
+    if (rc != MDB_READERS_FULL && rc != MDB_MAP_RESIZED) {
+      SetStatus(rc);
+      return;
+    }
+  }
+
+  // too many pinned txns open already (or not open), copy it out instead
+  zeroCopy = false;
+  value.mv_data = NULL;
+
+  if (range) {
+    SetStatus(database->GetRangeFromDatabase(
+        dbi
+      , key
+      , offset
+      , length
+      , value
+      , size
+      , snapshot
+    ));
+  } else {
+    SetStatus(database->GetFromDatabase(dbi, key, value, snapshot));
+  }
 }
 
 void ReadWorker::HandleOKCallback () {
   Nan::HandleScope scope;
 
   v8::Local<v8::Value> returnValue;
-  if (asBuffer) {
-    //TODO: could use NewBuffer if we carefully manage the lifecycle of `value`
-    //and avoid an an extra allocation. We'd have to clean up properly when not OK
-    //and let the new Buffer manage the data when OK
-    returnValue = Nan::CopyBuffer(value.data(), value.size()).ToLocalChecked();
+  if (zeroCopy) {
+    // the Buffer points into the map and holds `pin` (and so the read txn
+    // and the env) until it is garbage collected or released
+    returnValue = Database::NewPinnedBuffer(value, pin);
+    pin = NULL;
+  } else if (asBuffer) {
+    // the Buffer takes ownership of our malloc()ed copy
+    returnValue = Nan::NewBuffer(
+        (char*)value.mv_data
+      , value.mv_size
+    ).ToLocalChecked();
+    value.mv_data = NULL;
   } else {
-    returnValue = Nan::New<v8::String>(value.data(), value.size()).ToLocalChecked();
+    returnValue = Nan::New<v8::String>(
+        (char*)value.mv_data
+      , value.mv_size
+    ).ToLocalChecked();
   }
 
   v8::Local<v8::Value> argv[] = {
       Nan::Null()
     , returnValue
+    , Nan::New<v8::Number>((double)size)
+  };
+
+  callback->Call(range ? 3 : 2, argv);
+}
+
+/** GET MANY WORKER **/
+
+GetManyWorker::GetManyWorker (
+    Database *database
+  , Nan::Callback *callback
+  , MDB_dbi dbi
+  , std::vector< MDB_val* >* keys
+  , bool asBuffer
+  , bool sort
+  , Snapshot* snapshot
+) : AsyncWorker(database, callback)
+  , dbi(dbi)
+  , keys(keys)
+  , asBuffer(asBuffer)
+  , sort(sort)
+  , snapshot(snapshot)
+{ };
+
+GetManyWorker::~GetManyWorker () {
+  for (std::vector< MDB_val* >::iterator it = keys->begin()
+      ; it != keys->end()
+      ; ++it) {
+    MDB_val* key = *it;
+    LD_FREE_COPY(key);
+  }
+  delete keys;
+
+  // any left are those not handed over to a Buffer
+  for (std::vector< MDB_val >::iterator it = values.begin()
+      ; it != values.end()
+      ; ++it) {
+    free(it->mv_data);
+  }
+}
+
+void GetManyWorker::Execute () {
+  SetStatus(database->GetManyFromDatabase(
+      dbi
+    , *keys
+    , sort
+    , values
+    , snapshot
+  ));
+}
+
+void GetManyWorker::HandleOKCallback () {
+  Nan::HandleScope scope;
+
+  v8::Local<v8::Array> returnArray = Nan::New<v8::Array>(values.size());
+
+  for (size_t idx = 0; idx < values.size(); ++idx) {
+    MDB_val& value = values[idx];
+
+    if (value.mv_data == NULL) {
+      returnArray->Set(idx, Nan::Undefined());
+    } else if (asBuffer) {
+      returnArray->Set(idx, Nan::NewBuffer(
+          (char*)value.mv_data
+        , value.mv_size
+      ).ToLocalChecked());
+      value.mv_data = NULL;
+    } else {
+      returnArray->Set(idx, Nan::New<v8::String>(
+          (char*)value.mv_data
+        , value.mv_size
+      ).ToLocalChecked());
+    }
+  }
+
+  v8::Local<v8::Value> argv[] = {
+      Nan::Null()
+    , returnArray
   };
 
   callback->Call(2, argv);
@@ -125,19 +282,31 @@ DeleteWorker::DeleteWorker (
     Database *database
   , Nan::Callback *callback
   , MDB_val key
+  , MDB_dbi dbi
   , bool sync
   , v8::Local<v8::Object> &keyHandle
-) : IOWorker(database, callback, key, keyHandle)
+) : IOWorker(database, callback, key, dbi, keyHandle)
 {
   Nan::HandleScope scope;
 
   SaveToPersistent("key", keyHandle);
+  durable = sync;
+  bytes = key.mv_size;
 };
 
 DeleteWorker::~DeleteWorker () { }
 
-void DeleteWorker::Execute () {
-  SetStatus(database->DeleteFromDatabase(key));
+void DeleteWorker::Execute () { }
+
+int DeleteWorker::Write (MDB_txn *txn) {
+  int rc = mdb_del(txn, dbi, &key, NULL);
+  return rc == MDB_NOTFOUND ? 0 : rc;
+}
+
+void DeleteWorker::Complete () {
+  SetStatus(rc);
+  WorkComplete();
+  Destroy();
 }
 
 void DeleteWorker::WorkComplete () {
@@ -158,40 +327,322 @@ WriteWorker::WriteWorker (
     Database *database
   , Nan::Callback *callback
   , MDB_val key
+  , MDB_dbi dbi
   , MDB_val value
+  , ValueParts* parts
   , bool sync
+  , bool append
+  , WriteCondition condition
+  , MDB_val expected
   , v8::Local<v8::Object> &keyHandle
   , v8::Local<v8::Object> &valueHandle
-) : DeleteWorker(database, callback, key, sync, keyHandle)
+) : DeleteWorker(database, callback, key, dbi, sync, keyHandle)
   , value(value)
+  , parts(parts)
+  , flags((append ? MDB_APPEND : 0)
+      | (condition == WRITE_IF_ABSENT ? MDB_NOOVERWRITE : 0))
+  , condition(condition)
+  , expected(expected)
+  , applied(false)
   , valueHandle(valueHandle)
 {
   Nan::HandleScope scope;
 
   SaveToPersistent("value", valueHandle);
+  bytes += value.mv_size;
 };
 
 WriteWorker::~WriteWorker () { }
 
-void WriteWorker::Execute () {
-  SetStatus(database->PutToDatabase(key, value));
+int WriteWorker::Write (MDB_txn *txn) {
+  int rc;
+
+  applied = false;
+  if (condition == WRITE_IF_EQUALS) {
+    rc = ValueEquals(txn, dbi, &key, expected, applied);
+    if (rc != 0 || !applied)
+      return rc;
+  }
+
+  // on MDB_KEYEXIST mdb_put() points `data` at the existing value, which
+  // mustn't replace ours: it's disposed of afterwards, & replayed
+  MDB_val data = value;
+  if (parts != NULL)
+    rc = PutParts(txn, dbi, &key, parts->parts, data.mv_size, flags);
+  else
+    rc = mdb_put(txn, dbi, &key, &data, flags);
+
+  if (rc == MDB_KEYEXIST && condition == WRITE_IF_ABSENT)
+    return 0;
+  applied = rc == 0;
+
+  return rc;
 }
 
 void WriteWorker::WorkComplete () {
   Nan::HandleScope scope;
 
-  DisposeStringOrBufferFromSlice(GetFromPersistent("value"), value);
+  if (parts != NULL)
+    DisposeParts(parts);
+  else
+    DisposeStringOrBufferFromSlice(GetFromPersistent("value"), value);
+  if (condition == WRITE_IF_EQUALS)
+    DisposeStringOrBufferFromSlice(GetFromPersistent("expected"), expected);
   IOWorker::WorkComplete();
 }
 
+// a conditional put calls back with whether it went ahead
+void WriteWorker::HandleOKCallback () {
+  Nan::HandleScope scope;
+
+  if (condition == WRITE_ALWAYS)
+    return IOWorker::HandleOKCallback();
+
+  v8::Local<v8::Value> argv[] = {
+      Nan::Null()
+    , Nan::New<v8::Boolean>(applied)
+  };
+  callback->Call(2, argv);
+}
+
+/** CLEAR WORKER **/
+
+ClearWorker::ClearWorker (
+    Database *database
+  , Nan::Callback *callback
+  , MDB_dbi dbi
+  , bool sync
+) : AsyncWorker(database, callback)
+  , dbi(dbi)
+{
+  durable = sync;
+  mainDb = dbi == database->dbi;
+};
+
+ClearWorker::~ClearWorker () {}
+
+void ClearWorker::Execute () { }
+
+/*
+ * The main db may also hold the records of named dbs, whatever `maxDbs`
+ * this open was given, which mdb_drop() would take with it (leaking their
+ * pages). So it is read through for any first, and if there are, only the
+ * other entries are deleted, one by one.
+ */
+int ClearWorker::Write (MDB_txn *txn) {
+  if (!mainDb)
+    // a sub-db drop()ped is only emptied too, its dbi is never closed, see
+    // Database::subDbs
+    return mdb_drop(txn, dbi, 0);
+
+  MDB_cursor *cursor;
+  MDB_val key;
+  MDB_val value;
+  bool named = false;
+
+  int rc = mdb_cursor_open(txn, dbi, &cursor);
+  if (rc)
+    return rc;
+
+  rc = mdb_cursor_get(cursor, &key, &value, MDB_FIRST);
+  while (rc == 0 && !(named = mdb_cursor_is_db(cursor)))
+    rc = mdb_cursor_get(cursor, &key, &value, MDB_NEXT);
+
+  if (!named) {
+    mdb_cursor_close(cursor);
+    if (rc != MDB_NOTFOUND)
+      return rc;
+    return mdb_drop(txn, dbi, 0);
+  }
+
+  rc = mdb_cursor_get(cursor, &key, &value, MDB_FIRST);
+  while (rc == 0) {
+    if (mdb_cursor_is_db(cursor)) {
+      rc = mdb_cursor_get(cursor, &key, &value, MDB_NEXT);
+    } else {
+      // leaves the cursor on the entry after, which MDB_NEXT then returns
+      rc = mdb_cursor_del(cursor, 0);
+      if (rc == 0)
+        rc = mdb_cursor_get(cursor, &key, &value, MDB_NEXT);
+    }
+  }
+
+  mdb_cursor_close(cursor);
+
+  return rc == MDB_NOTFOUND ? 0 : rc;
+}
+
+void ClearWorker::Complete () {
+  SetStatus(rc);
+  WorkComplete();
+  Destroy();
+}
+
+/** DEL RANGE WORKER **/
+
+DelRangeWorker::DelRangeWorker (
+    Database *database
+  , Nan::Callback *callback
+  , MDB_dbi dbi
+  , MDB_val* gt
+  , MDB_val* gte
+  , MDB_val* lt
+  , MDB_val* lte
+  , uint32_t chunkSize
+  , bool sync
+) : AsyncWorker(database, callback)
+  , dbi(dbi)
+  , gt(gt)
+  , gte(gte)
+  , lt(lt)
+  , lte(lte)
+  , chunkSize(chunkSize)
+  , chunk(0)
+  , more(false)
+  , deleted(0)
+{
+  durable = sync;
+  // each chunk is a commit of its own, see Continue()
+  alone = true;
+};
+
+DelRangeWorker::~DelRangeWorker () {
+  LD_FREE_COPY(gt);
+  LD_FREE_COPY(gte);
+  LD_FREE_COPY(lt);
+  LD_FREE_COPY(lte);
+}
+
+void DelRangeWorker::Execute () { }
+
+int DelRangeWorker::Write (MDB_txn *txn) {
+  MDB_cursor *cursor;
+  MDB_val key;
+  MDB_val value;
+
+  chunk = 0;
+  more = false;
+  bytes = 0;
+
+  int rc = mdb_cursor_open(txn, dbi, &cursor);
+  if (rc)
+    return rc;
+
+  // every chunk seeks from the start of the range, whatever the chunks
+  // before it deleted is gone
+  MDB_val* lower = gte != NULL ? gte : gt;
+  if (lower != NULL) {
+    key = *lower;
+    rc = mdb_cursor_get(cursor, &key, &value, MDB_SET_RANGE);
+  } else {
+    rc = mdb_cursor_get(cursor, &key, &value, MDB_FIRST);
+  }
+
+  while (rc == 0) {
+    if ((lt != NULL && mdb_cmp(txn, dbi, &key, lt) >= 0)
+        || (lte != NULL && mdb_cmp(txn, dbi, &key, lte) > 0))
+      break;
+
+    // sub-db names in the main db can't be deleted like this
+    if ((gt != NULL && mdb_cmp(txn, dbi, &key, gt) <= 0)
+        || (gte != NULL && mdb_cmp(txn, dbi, &key, gte) < 0)
+        || mdb_cursor_is_db(cursor)) {
+      rc = mdb_cursor_get(cursor, &key, &value, MDB_NEXT);
+      continue;
+    }
+
+    // keep the txn's dirty page list bounded, commit & carry on in another
+    if (chunkSize != 0 && chunk == chunkSize) {
+      more = true;
+      break;
+    }
+
+    bytes += key.mv_size;
+    rc = mdb_cursor_del(cursor, 0);
+    if (rc == 0) {
+      chunk++;
+      // the del left the cursor on the entry after, MDB_NEXT returns it
+      rc = mdb_cursor_get(cursor, &key, &value, MDB_NEXT);
+    }
+  }
+
+  mdb_cursor_close(cursor);
+
+  return rc == MDB_NOTFOUND ? 0 : rc;
+}
+
+bool DelRangeWorker::Continue () {
+  deleted += chunk;
+  return more;
+}
+
+void DelRangeWorker::Complete () {
+  SetStatus(rc);
+  WorkComplete();
+  Destroy();
+}
+
+void DelRangeWorker::HandleOKCallback () {
+  Nan::HandleScope scope;
+
+  v8::Local<v8::Value> argv[] = {
+      Nan::Null()
+    , Nan::New<v8::Number>((double) deleted)
+  };
+  callback->Call(2, argv);
+}
+
+/** SUB DB WORKER **/
+
+SubDbWorker::SubDbWorker (
+    Database *database
+  , Nan::Callback *callback
+  , const std::string& name
+  , unsigned int flags
+) : AsyncWorker(database, callback)
+  , name(name)
+  , flags(flags)
+  , sharedEnv(database->AcquireEnv())
+{ };
+
+SubDbWorker::~SubDbWorker () {
+  if (sharedEnv != NULL)
+    ReleaseEnv(sharedEnv);
+}
+
+void SubDbWorker::Execute () {
+  SetStatus(database->OpenSubDatabase(sharedEnv, name.c_str(), flags, &dbi));
+}
+
+// the handle's id, see Database::subDbs
+void SubDbWorker::HandleOKCallback () {
+  Nan::HandleScope scope;
+
+  if (!database->IsOpenOn(sharedEnv)) {
+    v8::Local<v8::Value> argv[] = {
+        Nan::Error("database is not open")
+    };
+    callback->Call(1, argv);
+    return;
+  }
+
+  v8::Local<v8::Value> argv[] = {
+      Nan::Null()
+    , Nan::New<v8::Uint32>(database->RegisterSubDb(name, dbi))
+  };
+  callback->Call(2, argv);
+}
+
 /** APPROXIMATE SIZE WORKER **/
 
 ApproximateSizeWorker::ApproximateSizeWorker (
     Database *database
   , Nan::Callback *callback
+  , MDB_dbi dbi
   , MDB_val* start
   , MDB_val* end
 ) : AsyncWorker(database, callback)
+  , dbi(dbi)
   , start(start)
   , end(end)
 { };
@@ -202,18 +653,98 @@ ApproximateSizeWorker::~ApproximateSizeWorker () {
 }
 
 void ApproximateSizeWorker::Execute () {
-  size = database->ApproximateSizeFromDatabase(start, end);
+  SetStatus(database->ApproximateSizeFromDatabase(
+      dbi
+    , start
+    , end
+    , size
+    , exact
+    , error
+  ));
 }
 
 void ApproximateSizeWorker::HandleOKCallback () {
   Nan::HandleScope scope;
 
   v8::Local<v8::Value> returnValue = Nan::New<v8::Number>((double) size);
+  v8::Local<v8::Object> returnInfo = Nan::New<v8::Object>();
+  returnInfo->Set(Nan::New("exact").ToLocalChecked(), Nan::New<v8::Boolean>(exact));
+  returnInfo->Set(Nan::New("error").ToLocalChecked(), Nan::New<v8::Number>((double) error));
+
   v8::Local<v8::Value> argv[] = {
       Nan::Null()
     , returnValue
+    , returnInfo
   };
-  callback->Call(2, argv);
+  callback->Call(3, argv);
+}
+
+/** AGGREGATE WORKER **/
+
+AggregateWorker::AggregateWorker (
+    Database *database
+  , Nan::Callback *callback
+  , MDB_dbi dbi
+  , MDB_val* gt
+  , MDB_val* gte
+  , MDB_val* lt
+  , MDB_val* lte
+  , const std::vector< Filter >& filters
+  , const Aggregate& aggregate
+  , Snapshot* snapshot
+) : AsyncWorker(database, callback)
+  , dbi(dbi)
+  , gt(gt)
+  , gte(gte)
+  , lt(lt)
+  , lte(lte)
+  , filters(filters)
+  , aggregate(aggregate)
+  , snapshot(snapshot)
+{ };
+
+AggregateWorker::~AggregateWorker () {
+  LD_FREE_COPY(gt);
+  LD_FREE_COPY(gte);
+  LD_FREE_COPY(lt);
+  LD_FREE_COPY(lte);
+}
+
+void AggregateWorker::Execute () {
+  SetStatus(database->AggregateFromDatabase(
+      dbi
+    , gt
+    , gte
+    , lt
+    , lte
+    , filters
+    , aggregate
+    , snapshot
+  ));
+}
+
+void AggregateWorker::HandleOKCallback () {
+  Nan::HandleScope scope;
+
+  v8::Local<v8::Value> returnValue;
+
+  if (aggregate.op == Aggregate::COUNT) {
+    returnValue = Nan::New<v8::Number>((double) aggregate.count);
+  } else if (aggregate.op != Aggregate::SUM && aggregate.count == 0) {
+    // no min or max of nothing
+    returnValue = Nan::Undefined();
+  } else if (aggregate.field.IsFloat()) {
+    returnValue = Nan::New<v8::Number>(aggregate.real);
+  } else {
+    returnValue = Nan::New<v8::Number>((double) aggregate.integer);
+  }
+
+  v8::Local<v8::Value> argv[] = {
+      Nan::Null()
+    , returnValue
+    , Nan::New<v8::Number>((double) aggregate.count)
+  };
+  callback->Call(3, argv);
 }
 
 /** BACKUP WORKER **/
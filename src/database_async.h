@@ -23,6 +23,7 @@ public:
 
   virtual ~OpenWorker ();
   virtual void Execute ();
+  virtual void HandleOKCallback ();
 
 private:
   OpenOptions options;
@@ -46,6 +47,7 @@ public:
       Database *database
     , Nan::Callback *callback
     , MDB_val key
+    , MDB_dbi dbi
     , v8::Local<v8::Object> &keyHandle
   );
 
@@ -54,6 +56,7 @@ public:
 
 protected:
   MDB_val key;
+  MDB_dbi dbi;
   v8::Local<v8::Object> &keyHandle;
 };
 
@@ -63,8 +66,14 @@ public:
       Database *database
     , Nan::Callback *callback
     , MDB_val key
+    , MDB_dbi dbi
     , bool asBuffer
     , bool fillCache
+    , bool zeroCopy
+    , bool range
+    , uint64_t offset
+    , uint64_t length
+    , Snapshot* snapshot
     , v8::Local<v8::Object> &keyHandle
   );
 
@@ -74,21 +83,61 @@ public:
 
 private:
   bool asBuffer;
-  std::string value;
+  bool zeroCopy;
+  // getRange(), only `length` bytes from `offset` of a value `size` long
+  bool range;
+  uint64_t offset;
+  uint64_t length;
+  size_t size;
+  MDB_val value;
+  PinnedRead* pin;
+  Snapshot* snapshot;
+  // held for zero-copy reads, see GetPinnedFromDatabase()
+  SharedEnv* sharedEnv;
+};
+
+class GetManyWorker : public AsyncWorker {
+public:
+  GetManyWorker (
+      Database *database
+    , Nan::Callback *callback
+    , MDB_dbi dbi
+    , std::vector< MDB_val* >* keys
+    , bool asBuffer
+    , bool sort
+    , Snapshot* snapshot
+  );
+
+  virtual ~GetManyWorker ();
+  virtual void Execute ();
+  virtual void HandleOKCallback ();
+
+private:
+  MDB_dbi dbi;
+  std::vector< MDB_val* >* keys;
+  bool asBuffer;
+  bool sort;
+  std::vector< MDB_val > values;
+  Snapshot* snapshot;
 };
 
-class DeleteWorker : public IOWorker {
+// NOTE: write workers are never queued on the threadpool, they are run by
+// the Database writer thread, see Database::QueueWrite()
+class DeleteWorker : public IOWorker, public WriteRequest {
 public:
   DeleteWorker (
       Database *database
     , Nan::Callback *callback
     , MDB_val key
+    , MDB_dbi dbi
     , bool sync
     , v8::Local<v8::Object> &keyHandle
   );
 
   virtual ~DeleteWorker ();
   virtual void Execute ();
+  virtual int Write (MDB_txn *txn);
+  virtual void Complete ();
   virtual void WorkComplete ();
 
 protected:
@@ -100,26 +149,114 @@ public:
       Database *database
     , Nan::Callback *callback
     , MDB_val key
+    , MDB_dbi dbi
     , MDB_val value
+    , ValueParts* parts
     , bool sync
+    , bool append
+    , WriteCondition condition
+    , MDB_val expected
     , v8::Local<v8::Object> &keyHandle
     , v8::Local<v8::Object> &valueHandle
   );
 
   virtual ~WriteWorker ();
-  virtual void Execute ();
+  virtual int Write (MDB_txn *txn);
   virtual void WorkComplete ();
+  virtual void HandleOKCallback ();
 
 private:
   MDB_val value;
+  // the value as an Array of parts, see PutParts()
+  ValueParts* parts;
+  unsigned int flags;
+  WriteCondition condition;
+  // what the value must be, for WRITE_IF_EQUALS
+  MDB_val expected;
+  // whether the condition held & the put went ahead
+  bool applied;
   v8::Local<v8::Object> &valueHandle;
 };
 
+class ClearWorker : public AsyncWorker, public WriteRequest {
+public:
+  ClearWorker (
+      Database *database
+    , Nan::Callback *callback
+    , MDB_dbi dbi
+    , bool sync
+  );
+
+  virtual ~ClearWorker ();
+  virtual void Execute ();
+  virtual int Write (MDB_txn *txn);
+  virtual void Complete ();
+
+private:
+  MDB_dbi dbi;
+  // see Write()
+  bool mainDb;
+};
+
+class DelRangeWorker : public AsyncWorker, public WriteRequest {
+public:
+  DelRangeWorker (
+      Database *database
+    , Nan::Callback *callback
+    , MDB_dbi dbi
+    , MDB_val* gt
+    , MDB_val* gte
+    , MDB_val* lt
+    , MDB_val* lte
+    , uint32_t chunkSize
+    , bool sync
+  );
+
+  virtual ~DelRangeWorker ();
+  virtual void Execute ();
+  virtual int Write (MDB_txn *txn);
+  virtual bool Continue ();
+  virtual void Complete ();
+  virtual void HandleOKCallback ();
+
+private:
+  MDB_dbi dbi;
+  MDB_val* gt;
+  MDB_val* gte;
+  MDB_val* lt;
+  MDB_val* lte;
+  uint32_t chunkSize;
+  uint32_t chunk;
+  bool more;
+  uint64_t deleted;
+};
+
+class SubDbWorker : public AsyncWorker {
+public:
+  SubDbWorker (
+      Database *database
+    , Nan::Callback *callback
+    , const std::string& name
+    , unsigned int flags
+  );
+
+  virtual ~SubDbWorker ();
+  virtual void Execute ();
+  virtual void HandleOKCallback ();
+
+private:
+  std::string name;
+  unsigned int flags;
+  SharedEnv* sharedEnv;
+  MDB_dbi dbi;
+};
+
 class ApproximateSizeWorker : public AsyncWorker {
 public:
   ApproximateSizeWorker (
       Database *database
     , Nan::Callback *callback
+    , MDB_dbi dbi
     , MDB_val* start
     , MDB_val* end
   );
@@ -129,9 +266,42 @@ public:
   virtual void HandleOKCallback ();
 
   private:
+    MDB_dbi dbi;
     MDB_val* start;
     MDB_val* end;
     uint64_t size;
+    bool exact;
+    uint64_t error;
+};
+
+class AggregateWorker : public AsyncWorker {
+public:
+  AggregateWorker (
+      Database *database
+    , Nan::Callback *callback
+    , MDB_dbi dbi
+    , MDB_val* gt
+    , MDB_val* gte
+    , MDB_val* lt
+    , MDB_val* lte
+    , const std::vector< Filter >& filters
+    , const Aggregate& aggregate
+    , Snapshot* snapshot
+  );
+
+  virtual ~AggregateWorker ();
+  virtual void Execute ();
+  virtual void HandleOKCallback ();
+
+private:
+  MDB_dbi dbi;
+  MDB_val* gt;
+  MDB_val* gte;
+  MDB_val* lt;
+  MDB_val* lte;
+  std::vector< Filter > filters;
+  Aggregate aggregate;
+  Snapshot* snapshot;
 };
 
 class BackupWorker : public AsyncWorker {
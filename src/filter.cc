@@ -0,0 +1,397 @@
+/* Copyright (c) 2012-2016 LevelDOWN contributors
+ * See list at <https://github.com/level/leveldown#contributing>
+ * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
+ */
+
+#include <node.h>
+#include <node_buffer.h>
+#include <string.h>
+#include <algorithm>
+#include <nan.h>
+
+#include "filter.h"
+#include "common.h"
+
+namespace leveldown {
+
+// in FieldType order
+static const char* fieldTypes[] = {
+    "int8"
+  , "uint8"
+  , "int16le"
+  , "int16be"
+  , "uint16le"
+  , "uint16be"
+  , "int32le"
+  , "int32be"
+  , "uint32le"
+  , "uint32be"
+  , "int64le"
+  , "int64be"
+  , "floatle"
+  , "floatbe"
+  , "doublele"
+  , "doublebe"
+};
+
+size_t Field::Width () const {
+  switch (type) {
+    case FIELD_INT8:
+    case FIELD_UINT8:
+      return 1;
+    case FIELD_INT16LE:
+    case FIELD_INT16BE:
+    case FIELD_UINT16LE:
+    case FIELD_UINT16BE:
+      return 2;
+    case FIELD_INT32LE:
+    case FIELD_INT32BE:
+    case FIELD_UINT32LE:
+    case FIELD_UINT32BE:
+    case FIELD_FLOATLE:
+    case FIELD_FLOATBE:
+      return 4;
+    default:
+      return 8;
+  }
+}
+
+bool Field::IsFloat () const {
+  return type >= FIELD_FLOATLE;
+}
+
+bool Field::Read (const MDB_val& from, int64_t& integer, double& real) const {
+  size_t width = Width();
+
+  if (from.mv_size < offset || from.mv_size - offset < width)
+    return false;
+
+  const unsigned char* at = (const unsigned char*)from.mv_data + offset;
+  // the odd types are the little-endian ones, bar the single bytes
+  bool little = width == 1 || (type - FIELD_INT16LE) % 2 == 0;
+  uint64_t raw = 0;
+
+  if (little) {
+    for (size_t i = width; i-- > 0; )
+      raw = raw << 8 | at[i];
+  } else {
+    for (size_t i = 0; i < width; i++)
+      raw = raw << 8 | at[i];
+  }
+
+  switch (type) {
+    case FIELD_FLOATLE:
+    case FIELD_FLOATBE: {
+      uint32_t bits = (uint32_t)raw;
+      float f;
+      memcpy(&f, &bits, 4);
+      real = f;
+      return true;
+    }
+    case FIELD_DOUBLELE:
+    case FIELD_DOUBLEBE:
+      memcpy(&real, &raw, 8);
+      return true;
+    case FIELD_INT8:
+    case FIELD_INT16LE:
+    case FIELD_INT16BE:
+    case FIELD_INT32LE:
+    case FIELD_INT32BE: {
+      // sign-extend
+      unsigned int shift = 64 - width * 8;
+      integer = (int64_t)(raw << shift) >> shift;
+      return true;
+    }
+    default:
+      integer = (int64_t)raw;
+      return true;
+  }
+}
+
+bool Field::Read (const MDB_val& from, double& number) const {
+  int64_t integer;
+
+  if (!Read(from, integer, number))
+    return false;
+  if (!IsFloat())
+    number = (double)integer;
+  return true;
+}
+
+bool Filter::Matches (const MDB_val& key, const MDB_val& value) const {
+  const MDB_val& on = onValue ? value : key;
+  const char* data = (const char*)on.mv_data;
+
+  switch (kind) {
+    case PREFIX:
+      return on.mv_size >= bytes.size()
+        && memcmp(data, bytes.data(), bytes.size()) == 0;
+
+    case EQUALS:
+      return on.mv_size >= at
+        && on.mv_size - at >= bytes.size()
+        && memcmp(data + at, bytes.data(), bytes.size()) == 0;
+
+    case CONTAINS:
+      return std::search(
+          data
+        , data + on.mv_size
+        , bytes.begin()
+        , bytes.end()
+      ) != data + on.mv_size || bytes.empty();
+
+    case RANGE: {
+      double number;
+      if (!field.Read(on, number))
+        return false;
+      if (hasMin && (minInclusive ? number < min : number <= min))
+        return false;
+      if (hasMax && (maxInclusive ? number > max : number >= max))
+        return false;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void Aggregate::Add (const MDB_val& value) {
+  int64_t i;
+  double r;
+
+  if (!hasField) {
+    count++;
+    return;
+  }
+  if (!field.Read(value, i, r))
+    return;
+
+  bool first = count++ == 0;
+
+  if (field.IsFloat()) {
+    switch (op) {
+      case SUM:
+        real += r;
+        break;
+      case MIN:
+        if (first || r < real)
+          real = r;
+        break;
+      case MAX:
+        if (first || r > real)
+          real = r;
+        break;
+      default:
+        break;
+    }
+  } else {
+    switch (op) {
+      case SUM:
+        integer = (int64_t)((uint64_t)integer + (uint64_t)i);
+        break;
+      case MIN:
+        if (first || i < integer)
+          integer = i;
+        break;
+      case MAX:
+        if (first || i > integer)
+          integer = i;
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+static void CopyBytes (v8::Local<v8::Value> from, std::string& to) {
+  if (node::Buffer::HasInstance(from)) {
+    to.assign(node::Buffer::Data(from), node::Buffer::Length(from));
+  } else {
+    Nan::Utf8String str(from);
+    to.assign(*str, str.length());
+  }
+}
+
+static bool IsBytes (v8::Local<v8::Value> from) {
+  return from->IsString() || node::Buffer::HasInstance(from);
+}
+
+const char* ParseField (v8::Local<v8::Value> from, Field& field) {
+  Nan::HandleScope scope;
+
+  if (!from->IsObject())
+    return "a field must be an object with an offset & a type";
+
+  v8::Local<v8::Object> obj = from.As<v8::Object>();
+  v8::Local<v8::Value> offset = obj->Get(Nan::New("offset").ToLocalChecked());
+  v8::Local<v8::Value> type = obj->Get(Nan::New("type").ToLocalChecked());
+
+  if (!offset->IsUndefined()
+      && (!offset->IsNumber() || offset->NumberValue() < 0))
+    return "a field's offset must be a non-negative number";
+  field.offset = offset->IsNumber() ? (size_t)offset->NumberValue() : 0;
+
+  if (!type->IsString())
+    return "a field must have a type";
+
+  Nan::Utf8String name(type);
+  for (size_t i = 0; i < sizeof(fieldTypes) / sizeof(fieldTypes[0]); i++) {
+    if (strcmp(*name, fieldTypes[i]) == 0) {
+      field.type = (FieldType)i;
+      return NULL;
+    }
+  }
+
+  return "unknown field type";
+}
+
+const char* ParseAggregate (
+      v8::Local<v8::Object> options
+    , Aggregate& aggregate) {
+
+  static const char* ops[] = { "count", "sum", "min", "max" };
+
+  Nan::HandleScope scope;
+
+  aggregate.count = 0;
+  aggregate.integer = 0;
+  aggregate.real = 0;
+
+  if (options.IsEmpty())
+    return "aggregate() requires an op of count, sum, min or max";
+
+  v8::Local<v8::Value> op = options->Get(Nan::New("op").ToLocalChecked());
+  v8::Local<v8::Value> field = options->Get(Nan::New("field").ToLocalChecked());
+
+  if (!op->IsString())
+    return "aggregate() requires an op of count, sum, min or max";
+
+  Nan::Utf8String name(op);
+  size_t i = 0;
+  while (i < 4 && strcmp(*name, ops[i]) != 0)
+    i++;
+  if (i == 4)
+    return "aggregate() requires an op of count, sum, min or max";
+  aggregate.op = (Aggregate::Op)i;
+
+  aggregate.hasField = !field->IsUndefined();
+  if (!aggregate.hasField) {
+    return aggregate.op == Aggregate::COUNT
+      ? NULL
+      : "aggregate() requires a field unless counting";
+  }
+
+  return ParseField(field, aggregate.field);
+}
+
+// the bounds of a RANGE filter, from gt/gte/lt/lte/eq
+static const char* ParseBounds (v8::Local<v8::Object> obj, Filter& filter) {
+  static const char* names[] = { "gt", "gte", "lt", "lte", "eq" };
+
+  filter.hasMin = false;
+  filter.hasMax = false;
+
+  for (size_t i = 0; i < 5; i++) {
+    v8::Local<v8::Value> bound = obj->Get(Nan::New(names[i]).ToLocalChecked());
+    if (bound->IsUndefined())
+      continue;
+    if (!bound->IsNumber())
+      return "a field filter's bounds must be numbers";
+
+    double number = bound->NumberValue();
+    if (i != 2 && i != 3) {
+      filter.hasMin = true;
+      filter.min = number;
+      filter.minInclusive = i != 0;
+    }
+    if (i >= 2) {
+      filter.hasMax = true;
+      filter.max = number;
+      filter.maxInclusive = i != 2;
+    }
+  }
+
+  return NULL;
+}
+
+static const char* ParseFilter (v8::Local<v8::Value> from, Filter& filter) {
+  if (!from->IsObject())
+    return "a filter must be an object";
+
+  v8::Local<v8::Object> obj = from.As<v8::Object>();
+  v8::Local<v8::Value> on = obj->Get(Nan::New("on").ToLocalChecked());
+  v8::Local<v8::Value> prefix = obj->Get(Nan::New("prefix").ToLocalChecked());
+  v8::Local<v8::Value> equals = obj->Get(Nan::New("equals").ToLocalChecked());
+  v8::Local<v8::Value> contains = obj->Get(Nan::New("contains").ToLocalChecked());
+  v8::Local<v8::Value> field = obj->Get(Nan::New("field").ToLocalChecked());
+
+  if (on->IsUndefined()) {
+    filter.onValue = false;
+  } else {
+    Nan::Utf8String name(on);
+    if (strcmp(*name, "key") != 0 && strcmp(*name, "value") != 0)
+      return "a filter must be `on` 'key' or 'value'";
+    filter.onValue = strcmp(*name, "value") == 0;
+  }
+
+  if (IsBytes(prefix)) {
+    filter.kind = Filter::PREFIX;
+    CopyBytes(prefix, filter.bytes);
+  } else if (IsBytes(equals)) {
+    v8::Local<v8::Value> at = obj->Get(Nan::New("at").ToLocalChecked());
+    if (!at->IsUndefined() && (!at->IsNumber() || at->NumberValue() < 0))
+      return "a filter's `at` must be a non-negative number";
+    filter.kind = Filter::EQUALS;
+    filter.at = at->IsNumber() ? (size_t)at->NumberValue() : 0;
+    CopyBytes(equals, filter.bytes);
+  } else if (IsBytes(contains)) {
+    filter.kind = Filter::CONTAINS;
+    CopyBytes(contains, filter.bytes);
+  } else if (!field->IsUndefined()) {
+    filter.kind = Filter::RANGE;
+    const char* error = ParseField(field, filter.field);
+    if (error == NULL)
+      error = ParseBounds(obj, filter);
+    return error;
+  } else {
+    return "a filter needs a prefix, equals, contains or field";
+  }
+
+  return NULL;
+}
+
+const char* ParseFilters (
+      v8::Local<v8::Object> options
+    , std::vector< Filter >* filters) {
+
+  Nan::HandleScope scope;
+  v8::Local<v8::String> key = Nan::New("filter").ToLocalChecked();
+
+  if (options.IsEmpty() || !options->Has(key))
+    return NULL;
+
+  v8::Local<v8::Value> from = options->Get(key);
+  if (from->IsUndefined() || from->IsNull())
+    return NULL;
+
+  v8::Local<v8::Array> array;
+  if (from->IsArray()) {
+    array = from.As<v8::Array>();
+  } else {
+    array = Nan::New<v8::Array>(1);
+    array->Set(0, from);
+  }
+
+  for (uint32_t i = 0; i < array->Length(); i++) {
+    Filter filter;
+    const char* error = ParseFilter(array->Get(i), filter);
+    if (error != NULL)
+      return error;
+    if (filters != NULL)
+      filters->push_back(filter);
+  }
+
+  return NULL;
+}
+
+} // namespace leveldown
@@ -0,0 +1,115 @@
+/* Copyright (c) 2012-2016 LevelDOWN contributors
+ * See list at <https://github.com/level/leveldown#contributing>
+ * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
+ */
+
+#ifndef LD_FILTER_H
+#define LD_FILTER_H
+
+#include <string>
+#include <vector>
+#include <node.h>
+#include <nan.h>
+
+#include "leveldown.h"
+
+namespace leveldown {
+
+enum FieldType {
+    FIELD_INT8
+  , FIELD_UINT8
+  , FIELD_INT16LE
+  , FIELD_INT16BE
+  , FIELD_UINT16LE
+  , FIELD_UINT16BE
+  , FIELD_INT32LE
+  , FIELD_INT32BE
+  , FIELD_UINT32LE
+  , FIELD_UINT32BE
+  , FIELD_INT64LE
+  , FIELD_INT64BE
+  , FIELD_FLOATLE
+  , FIELD_FLOATBE
+  , FIELD_DOUBLELE
+  , FIELD_DOUBLEBE
+};
+
+// a fixed-width number `offset` bytes into a key or value, named as the
+// Buffer methods that read them, e.g. `'uint32be'`
+struct Field {
+  size_t offset;
+  FieldType type;
+
+  size_t Width () const;
+  bool IsFloat () const;
+  // false if `from` is too short to hold it, else one of `integer` or
+  // `real` is set, as IsFloat()
+  bool Read (const MDB_val& from, int64_t& integer, double& real) const;
+  bool Read (const MDB_val& from, double& number) const;
+};
+
+// one of an iterator's `filter`s, evaluated on the worker thread so that
+// entries not matching all of them are never copied out, see Matches()
+struct Filter {
+  enum Kind { PREFIX, EQUALS, CONTAINS, RANGE };
+
+  Kind kind;
+  // of the value rather than the key
+  bool onValue;
+  // PREFIX, EQUALS & CONTAINS
+  std::string bytes;
+  // EQUALS
+  size_t at;
+  // RANGE
+  Field field;
+  bool hasMin;
+  bool minInclusive;
+  double min;
+  bool hasMax;
+  bool maxInclusive;
+  double max;
+
+  bool Matches (const MDB_val& key, const MDB_val& value) const;
+};
+
+static inline bool MatchesAll (
+      const std::vector< Filter >& filters
+    , const MDB_val& key
+    , const MDB_val& value) {
+  for (std::vector< Filter >::const_iterator it = filters.begin()
+      ; it != filters.end()
+      ; ++it) {
+    if (!it->Matches(key, value))
+      return false;
+  }
+  return true;
+}
+
+// the running result of an aggregate(), Add()ed to with each value in range
+struct Aggregate {
+  enum Op { COUNT, SUM, MIN, MAX };
+
+  Op op;
+  // only counting needs no field, values too short to hold it are skipped
+  bool hasField;
+  Field field;
+  uint64_t count;
+  // as field.IsFloat(), SUM wraps rather than overflow
+  int64_t integer;
+  double real;
+
+  void Add (const MDB_val& value);
+};
+
+// called in the main thread, each returns why `from` is no good, or NULL
+const char* ParseField (v8::Local<v8::Value> from, Field& field);
+const char* ParseAggregate (v8::Local<v8::Object> options, Aggregate& aggregate);
+// `filters` may be NULL, only to check them
+const char* ParseFilters (
+      v8::Local<v8::Object> options
+    , std::vector< Filter >* filters
+);
+
+} // namespace leveldown
+
+#endif
@@ -5,21 +5,100 @@
 
 #include <node.h>
 #include <node_buffer.h>
+#include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include <nan.h>
 
 #include "database.h"
 #include "iterator.h"
 #include "iterator_async.h"
+#include "snapshot.h"
 #include "common.h"
 
 namespace leveldown {
 
 static Nan::Persistent<v8::FunctionTemplate> iterator_constructor;
 
+SlabBatch::SlabBatch () : data(NULL), size(0), capacity(0) {
+  offsets.push_back(0);
+}
+
+SlabBatch::~SlabBatch () {
+  free(data);
+}
+
+bool SlabBatch::Reserve (size_t more) {
+  if (size + more <= capacity)
+    return true;
+
+  size_t want = capacity < 4096 ? 4096 : capacity * 2;
+  if (want < size + more)
+    want = size + more;
+
+  char* grown = (char*)realloc(data, want);
+  if (grown == NULL)
+    return false;
+
+  data = grown;
+  capacity = want;
+  return true;
+}
+
+bool SlabBatch::Append (const MDB_val& key, const MDB_val& value) {
+  if (!Reserve(key.mv_size + value.mv_size))
+    return false;
+
+  if (key.mv_size > 0)
+    memcpy(data + size, key.mv_data, key.mv_size);
+  size += key.mv_size;
+  offsets.push_back(size);
+
+  if (value.mv_size > 0)
+    memcpy(data + size, value.mv_data, value.mv_size);
+  size += value.mv_size;
+  offsets.push_back(size);
+
+  return true;
+}
+
+void SlabBatch::PutUInt32 (uint32_t value) {
+  unsigned char* out = (unsigned char*)(data + size);
+  out[0] = value & 0xff;
+  out[1] = (value >> 8) & 0xff;
+  out[2] = (value >> 16) & 0xff;
+  out[3] = (value >> 24) & 0xff;
+  size += 4;
+}
+
+// append the offset table & count, called once all entries are in
+bool SlabBatch::Finish () {
+  if (!Reserve((offsets.size() + 1) * 4))
+    return false;
+
+  for (std::vector< uint32_t >::iterator it = offsets.begin()
+      ; it != offsets.end()
+      ; ++it) {
+    PutUInt32(*it);
+  }
+  PutUInt32(Count());
+
+  return true;
+}
+
+// hand the malloc()ed slab over, to a Buffer
+char* SlabBatch::Release () {
+  char* released = data;
+  data = NULL;
+  size = 0;
+  capacity = 0;
+  return released;
+}
+
 Iterator::Iterator (
     Database* database
   , uint32_t id
+  , MDB_dbi dbi
   , MDB_val* start
   , MDB_val* end
   , bool reverse
@@ -34,8 +113,15 @@ Iterator::Iterator (
   , bool keyAsBuffer
   , bool valueAsBuffer
   , size_t highWaterMark
+  , uint32_t refreshMs
+  , uint32_t refreshEntries
+  , size_t prefetchBytes
+  , const std::vector< Filter >& filters
+  , Snapshot* snapshot
+  , v8::Local<v8::Object> snapshotHandle
 ) : database(database)
   , id(id)
+  , dbi(dbi)
   , start(start)
   , end(end)
   , reverse(reverse)
@@ -46,15 +132,57 @@ Iterator::Iterator (
   , lte(lte)
   , gt(gt)
   , gte(gte)
+  , filters(filters)
   , highWaterMark(highWaterMark)
+  , refreshMs(refreshMs)
+  , refreshEntries(refreshEntries)
+  , refreshedAt(uv_hrtime())
+  , sinceRefresh(0)
+  , parked(false)
+  , parkedPositioned(false)
+  , parkedExhausted(false)
+  , snapshot(snapshot)
+  , prefetchBytes(prefetchBytes)
+  , prefetching(false)
+  , seekGeneration(0)
+  , prefetched(false)
+  , prefetchSlab(NULL)
+  , prefetchSize(0)
+  , prefetchEntries(0)
+  , prefetchFinished(false)
+  , prefetchWaiting(NULL)
   , keyAsBuffer(keyAsBuffer)
   , valueAsBuffer(valueAsBuffer)
 {
   Nan::HandleScope scope;
 
+  uv_mutex_init(&cursorMutex);
+  uv_mutex_init(&seekMutex);
+
+  if (snapshot != NULL) {
+    // held until End()ed, see Release()
+    snapshot->Ref();
+    this->snapshotHandle.Reset(snapshotHandle);
+  }
+
+  if (snapshot != NULL || !database->PoolsReads()) {
+    // a snapshot's txn isn't ours to renew, nor is a txn tied to the
+    // thread that began it
+    this->refreshMs = 0;
+    this->refreshEntries = 0;
+  }
+
   started    = false;
-  rc         = database->NewCursor(&txn, &cursor);
-  alloc      = rc == 0;
+  opened     = false;
+  alloc      = false;
+  rc         = 0;
+  seekPending = false;
+  if (snapshot == NULL && !database->PoolsReads()) {
+    // a txn tied to the thread that began it has to be begun here
+    database->LockMap();
+    Open();
+    database->UnlockMap();
+  }
   count      = 0;
   seeking    = false;
   nexting    = false;
@@ -69,6 +197,10 @@ Iterator::~Iterator () {
   LD_FREE_COPY(gt);
   LD_FREE_COPY(lte);
   LD_FREE_COPY(gte);
+  DiscardPrefetched();
+  delete prefetchWaiting;
+  uv_mutex_destroy(&cursorMutex);
+  uv_mutex_destroy(&seekMutex);
 };
 
 bool Iterator::GetIterator () {
@@ -118,25 +250,27 @@ bool Iterator::GetIterator () {
   return false;
 }
 
-bool Iterator::Read (std::string& key, std::string& value) {
-  // if it's not the first call, move to next item.
-  if (!GetIterator() && !seeking) {
+bool Iterator::Read (MDB_val& key, MDB_val& value) {
+  while (true) {
+    // if it's not the first call, move to next item.
+    if (!GetIterator() && !seeking) {
+      if (!IsValid())
+        return false;
+      if (reverse)
+        Prev();
+      else
+        Next();
+    }
+
+    seeking = false;
+
+    // now check if this is the end or not, if not then return the key & value
     if (!IsValid())
       return false;
-    if (reverse)
-      Prev();
-    else
-      Next();
-  }
 
-  seeking = false;
-
-  // now check if this is the end or not, if not then return the key & value
-  if (IsValid()) {
     int isEnd = end == NULL ? 1 : CompareRev(end);
 
-    if ((limit < 0 || ++count <= limit)
-      && (end == NULL
+    if (!((end == NULL
           || (reverse && (isEnd <= 0))
           || (!reverse && (isEnd >= 0)))
       && ( lt  != NULL ? (CompareRev(lt) > 0)
@@ -145,46 +279,308 @@ bool Iterator::Read (std::string& key, std::string& value) {
       && ( gt  != NULL ? (CompareRev(gt) < 0)
          : gte != NULL ? (CompareRev(gte) <= 0)
          : true )
-    ) {
-      if (keys)
-        key.assign((char *)currentKey.mv_data, currentKey.mv_size);
-      if (values)
-        value.assign((char *)currentValue.mv_data, currentValue.mv_size);
-      return true;
+    )) {
+      // rc = MDB_NOTFOUND;
+      return false;
     }
-    // rc = MDB_NOTFOUND;
+
+    // entries filtered out are stepped over, not counted toward `limit`
+    if (!filters.empty() && !MatchesAll(filters, currentKey, currentValue))
+      continue;
+
+    if (limit >= 0 && count >= limit)
+      return false;
+    count++;
+
+    // NOTE: these point into the map, only valid until the cursor moves
+    if (keys)
+      key = currentKey;
+    if (values)
+      value = currentValue;
+    return true;
   }
+}
 
-  return false;
+bool Iterator::IteratorNext (
+      SlabBatch& batch
+    , bool prefetch
+    , uint32_t generation) {
+
+  int lockRc = LockRead();
+  if (lockRc != 0) {
+    // the snapshot's txn couldn't be begun
+    rc = lockRc;
+    return false;
+  }
+
+  uv_mutex_lock(&seekMutex);
+  bool stale = prefetch && generation != seekGeneration;
+  bool seek = !stale && seekPending;
+  if (seek) {
+    // ours to seek with once seekMutex is let go of
+    seekKey.swap(pendingSeek);
+    seekPending = false;
+  }
+  uv_mutex_unlock(&seekMutex);
+
+  if (stale) {
+    // seek()ed before we got the cursor, PrefetchDone() drops the batch
+    UnlockRead();
+    return true;
+  }
+
+  if (!opened)
+    Open();
+  Unpark();
+  Reposition();
+  if (seek) {
+    MDB_val k;
+    k.mv_data = (void*)seekKey.data();
+    k.mv_size = seekKey.size();
+    SeekTo(&k);
+  }
+  if (RefreshDue())
+    Refresh();
+  bool more = ReadBatch(batch, prefetch ? prefetchBytes : highWaterMark);
+  SavePosition();
+  Park();
+  UnlockRead();
+
+  return more;
+}
+
+/*
+ * The txn & cursor are set up by the first read, on the threadpool, rather
+ * than by the constructor on the main thread, where waiting on the map
+ * lock (behind a resize waiting on long reads) would hold up the event
+ * loop. Called holding the map lock, and a snapshot's with one.
+ */
+void Iterator::Open () {
+  opened = true;
+
+  if (snapshot != NULL)
+    rc = snapshot->OpenCursor(dbi, &cursor);
+  else
+    rc = database->NewCursor(dbi, &txn, &cursor, NULL);
+  alloc = rc == 0;
+  mapGeneration = database->MapGeneration();
+}
+
+// other reads on a snapshot wait while we're on its txn; nothing is held
+// if an error is returned
+int Iterator::LockRead () {
+  uv_mutex_lock(&cursorMutex);
+  database->LockMap();
+  if (snapshot != NULL) {
+    int lockRc = snapshot->Lock(&txn);
+    if (lockRc != 0) {
+      database->UnlockMap();
+      uv_mutex_unlock(&cursorMutex);
+      return lockRc;
+    }
+  }
+  return 0;
+}
+
+// as LockRead(), for the main thread, false rather than wait on a batch
+// being read, a resize or a read on the snapshot (or with its error, for
+// the next read to give)
+bool Iterator::TryLockRead () {
+  if (uv_mutex_trylock(&cursorMutex) != 0)
+    return false;
+  if (!database->TryLockMap()) {
+    uv_mutex_unlock(&cursorMutex);
+    return false;
+  }
+  if (snapshot != NULL && snapshot->TryLock(&txn) != 0) {
+    database->UnlockMap();
+    uv_mutex_unlock(&cursorMutex);
+    return false;
+  }
+  return true;
+}
+
+void Iterator::UnlockRead () {
+  if (snapshot != NULL)
+    snapshot->Unlock();
+  database->UnlockMap();
+  uv_mutex_unlock(&cursorMutex);
 }
 
-bool Iterator::IteratorNext (std::vector<std::pair<std::string, std::string> >& result) {
-  size_t size = 0;
+bool Iterator::ReadBatch (SlabBatch& batch, size_t bytes) {
   while(true) {
-    std::string key, value;
+    MDB_val key;
+    MDB_val value;
+
+    key.mv_size = 0;
+    key.mv_data = NULL;
+    value.mv_size = 0;
+    value.mv_data = NULL;
+
     bool ok = Read(key, value);
 
     if (ok) {
-      result.push_back(std::make_pair(key, value));
-      size = size + key.size() + value.size();
+      if (!batch.Append(key, value)) {
+        rc = ENOMEM;
+        return false;
+      }
 
-      if (size > highWaterMark)
+      sinceRefresh++;
+
+      if (batch.size > bytes)
         return true;
 
+      if (RefreshDue())
+        Refresh();
+
     } else {
       return false;
     }
   }
 }
 
-void Iterator::IteratorEnd () {
-  if (alloc) {
-    mdb_cursor_close(cursor);
-    mdb_txn_abort(txn);
+/*
+ * The txn survives the map being moved by Database::ResizeMap() but the
+ * cursor's page pointers don't, so when that has happened since the map
+ * was last touched, the cursor is put back on a copy of the key it was on
+ * (the same snapshot, so it's still there). Both are called holding the
+ * map lock.
+ */
+void Iterator::Reposition () {
+  uint32_t generation = database->MapGeneration();
+
+  if (generation == mapGeneration)
+    return;
+
+  mapGeneration = generation;
+
+  if (!alloc || !started)
+    return;
+
+  if (rc == MDB_NOTFOUND) {
+    // run out, but a seek() may still use it
+    rc = mdb_cursor_renew(txn, cursor);
+    if (rc == 0)
+      rc = MDB_NOTFOUND;
+    return;
   }
+
+  if (!IsValid())
+    return;
+
+  rc = mdb_cursor_renew(txn, cursor);
+  if (rc != 0)
+    return;
+  currentKey.mv_data = (void*)lastKey.data();
+  currentKey.mv_size = lastKey.size();
+  rc = mdb_cursor_get(cursor, &currentKey, &currentValue, MDB_SET_KEY);
+}
+
+bool Iterator::RefreshDue () {
+  if (!alloc || (started && !IsValid()))
+    return false;
+
+  if (refreshEntries != 0 && sinceRefresh >= refreshEntries)
+    return true;
+
+  return refreshMs != 0
+    && uv_hrtime() - refreshedAt >= (uint64_t)refreshMs * 1000000;
+}
+
+/*
+ * Holding one read txn for the whole of a long scan keeps LMDB from reusing
+ * any page freed since it began, so with `refreshMs` or `refreshEntries`
+ * the txn is renewed on the latest data every so often and the cursor put
+ * back just past the last entry read. Entries written or deleted behind it
+ * meanwhile may or may not be seen. Called holding the map lock.
+ */
+void Iterator::Refresh () {
+  Park();
+  Unpark();
+}
+
+/*
+ * With refreshes the txn isn't held while JS works through a batch either:
+ * it's reset as each batch is done, on where the cursor was, & renewed by
+ * Unpark() at the start of the next. That goes for an iterator that has
+ * run out too, which only has its txn renewed by the next read or seek().
+ */
+void Iterator::Park () {
+  if (parked || !alloc || (refreshMs == 0 && refreshEntries == 0))
+    return;
+
+  parkedExhausted = started && !IsValid();
+  parkedPositioned = started && IsValid();
+  if (parkedPositioned)
+    lastKey.assign((const char*)currentKey.mv_data, currentKey.mv_size);
+
+  mdb_txn_reset(txn);
+  parked = true;
+}
+
+void Iterator::Unpark () {
+  if (!parked)
+    return;
+
+  parked = false;
+  refreshedAt = uv_hrtime();
+  sinceRefresh = 0;
+  // the cursor is renewed here, whatever the map did meanwhile
+  mapGeneration = database->MapGeneration();
+
+  rc = mdb_txn_renew(txn);
+  if (rc == 0)
+    rc = mdb_cursor_renew(txn, cursor);
+  if (rc == 0 && parkedExhausted) {
+    // still run out, unless seek()ed back onto something
+    rc = MDB_NOTFOUND;
+    return;
+  }
+  if (rc || !parkedPositioned)
+    return;
+
+  MDB_val k;
+  k.mv_data = (void*)lastKey.data();
+  k.mv_size = lastKey.size();
+
+  Seek(&k);
+  if (IsValid() && Compare(&k) == 0)
+    return; // Read() steps past it as usual, unless seek()ed there
+
+  // it's gone, so the cursor is to be left on whatever comes next
+  if (reverse) {
+    if (rc == MDB_NOTFOUND)
+      SeekToLast();
+    else if (IsValid())
+      Prev();
+  }
+  seeking = true;
+}
+
+void Iterator::SavePosition () {
+  if (database->IsGrowable() && started && IsValid())
+    lastKey.assign((const char*)currentKey.mv_data, currentKey.mv_size);
+}
+
+void Iterator::IteratorEnd () {
+  if (!alloc)
+    return;
+
+  // the snapshot is kept open for us, but its txn may fail to be begun
+  if (snapshot != NULL && snapshot->Lock(&txn) != 0)
+    return;
+  database->ReleaseCursor(txn, cursor, snapshot);
 }
 
 void Iterator::Release () {
+  DiscardPrefetched();
+
+  if (snapshot != NULL) {
+    snapshot->Unref();
+    snapshotHandle.Reset();
+    snapshot = NULL;
+  }
+
   database->ReleaseIterator(id);
 }
 
@@ -196,12 +592,133 @@ void checkEndCallback (Iterator* iterator) {
   }
 }
 
+void Iterator::QueueNext (Nan::Callback* callback, bool prefetch) {
+  NextWorker* worker = new NextWorker(
+      this
+    , callback
+    , checkEndCallback
+    , prefetch
+    , seekGeneration
+  );
+  // persist to prevent accidental GC
+  v8::Local<v8::Object> _this = handle();
+  worker->SaveToPersistent("iterator", _this);
+  nexting = true;
+  prefetching = prefetch;
+  Nan::AsyncQueueWorker(worker);
+}
+
+/*
+ * With `prefetchBytes`, as soon as a batch has been handed to JS the next
+ * one is read in the background, so that the read (and any page faults)
+ * overlaps JS working through the batch it has. It is held here until
+ * next() asks for it, or handed straight over if next() was already
+ * waiting on it. At most one batch is read ahead, so no more than about
+ * `prefetchBytes` are buffered.
+ */
+void Iterator::Prefetch (bool finished) {
+  if (prefetchBytes == 0 || finished || ended || nexting)
+    return;
+
+  QueueNext(NULL, true);
+}
+
+void Iterator::PrefetchDone (
+      char* slab
+    , size_t size
+    , size_t entries
+    , bool finished
+    , const char* error
+    , uint32_t generation) {
+
+  prefetching = false;
+
+  if (generation != seekGeneration) {
+    // seek()ed since it was queued, what it read is from where the cursor
+    // was & wasn't handed out, so doesn't count toward `limit`. No worker
+    // is in flight to touch `count` meanwhile
+    count -= (int)entries;
+    free(slab);
+
+    if (prefetchWaiting != NULL) {
+      Nan::Callback* callback = prefetchWaiting;
+      prefetchWaiting = NULL;
+      if (ended) {
+        Nan::HandleScope scope;
+        v8::Local<v8::Value> argv[] = {
+            Nan::Error("cannot call next() after end()")
+        };
+        callback->Call(1, argv);
+        delete callback;
+      } else {
+        QueueNext(callback, false);
+      }
+    }
+    return;
+  }
+
+  prefetched = true;
+  prefetchSlab = slab;
+  prefetchSize = size;
+  prefetchEntries = entries;
+  prefetchFinished = finished;
+  prefetchError = error != NULL ? error : "";
+
+  if (prefetchWaiting != NULL) {
+    Nan::Callback* callback = prefetchWaiting;
+    prefetchWaiting = NULL;
+    DeliverPrefetched(callback);
+    delete callback;
+  }
+}
+
+void Iterator::DeliverPrefetched (Nan::Callback* callback) {
+  Nan::HandleScope scope;
+
+  prefetched = false;
+  prefetchEntries = 0;
+
+  if (!prefetchError.empty()) {
+    v8::Local<v8::Value> argv[] = {
+        Nan::Error(prefetchError.c_str())
+    };
+    prefetchError.clear();
+    callback->Call(1, argv);
+    return;
+  }
+
+  // as NextWorker::HandleOKCallback()
+  v8::Local<v8::Value> returnSlab =
+      Nan::NewBuffer(prefetchSlab, prefetchSize).ToLocalChecked();
+  prefetchSlab = NULL;
+
+  Prefetch(prefetchFinished);
+
+  v8::Local<v8::Value> argv[] = {
+      Nan::Null()
+    , returnSlab
+    , Nan::New<v8::Boolean>(prefetchFinished)
+  };
+  callback->Call(3, argv);
+}
+
+// what was read ahead is given back to `limit`, call with no worker in
+// flight
+void Iterator::DiscardPrefetched () {
+  free(prefetchSlab);
+  prefetchSlab = NULL;
+  prefetched = false;
+  prefetchError.clear();
+  count -= (int)prefetchEntries;
+  prefetchEntries = 0;
+}
+
 int Iterator::Compare (MDB_val* b) {
-  return mdb_cmp(txn, database->dbi, &currentKey, b);
+  return mdb_cmp(txn, dbi, &currentKey, b);
 }
 
 int Iterator::CompareRev (MDB_val* a) {
-  return mdb_cmp(txn, database->dbi, a, &currentKey);
+  return mdb_cmp(txn, dbi, a, &currentKey);
 }
 
 void Iterator::Seek (MDB_val* k) {
@@ -230,51 +747,84 @@ bool Iterator::IsValid () {
   return rc == 0;
 }
 
+/*
+ * Where seek() puts the cursor, the next read goes on from there. Called
+ * holding the read lock, see LockRead().
+ */
+void Iterator::SeekTo (MDB_val* k) {
+  GetIterator();
+
+  // having run out is no reason not to seek, an error is
+  if (!alloc || (rc != 0 && rc != MDB_NOTFOUND))
+    return;
+
+  Seek(k);
+  seeking = true;
+
+  if (IsValid()) {
+    int cmp = Compare(k);
+    if (cmp > 0 && reverse) {
+      Prev();
+    } else if (cmp < 0 && !reverse) {
+      Next();
+    }
+  } else {
+    if (reverse) {
+      SeekToLast();
+    } else {
+      SeekToFirst();
+    }
+    if (IsValid()) {
+      int cmp = Compare(k);
+      if (cmp > 0 && reverse) {
+        SeekToFirst();
+        if (IsValid())
+          Prev();
+      } else if (cmp < 0 && !reverse) {
+        SeekToLast();
+        if (IsValid())
+          Next();
+      }
+    }
+  }
+}
+
 NAN_METHOD(Iterator::Seek) {
   Iterator* iterator = Nan::ObjectWrap::Unwrap<Iterator>(info.This());
+  Nan::Utf8String key(info[0]);
+
+  // doesn't wait on a batch being read (with filters there's no telling
+  // how long that takes) or on a resize: then, as before the first read,
+  // the seek is left for the next read to make
+  bool locked = iterator->opened && iterator->TryLockRead();
+
+  // anything read ahead is from where the cursor was, a read ahead still
+  // in flight sees the new generation & doesn't read, see IteratorNext()
+  uv_mutex_lock(&iterator->seekMutex);
+  iterator->seekGeneration++;
+  iterator->seekPending = !locked;
+  if (!locked)
+    iterator->pendingSeek.assign(*key, key.length());
+  uv_mutex_unlock(&iterator->seekMutex);
 
-  iterator->GetIterator();
+  if (!iterator->prefetching)
+    iterator->DiscardPrefetched();
 
-  if (!iterator->IsValid()) {
+  if (!locked) {
     info.GetReturnValue().Set(info.Holder());
     return;
   }
 
-  Nan::Utf8String key(info[0]);
-
   MDB_val k;
   k.mv_data = (void*)*key;
   k.mv_size = key.length();
 
-  iterator->Seek(&k);
-  iterator->seeking = true;
-
-  if (iterator->IsValid()) {
-    int cmp = iterator->Compare(&k);
-    if (cmp > 0 && iterator->reverse) {
-      iterator->Prev();
-    } else if (cmp < 0 && !iterator->reverse) {
-      iterator->Next();
-    }
-  } else {
-    if (iterator->reverse) {
-      iterator->SeekToLast();
-    } else {
-      iterator->SeekToFirst();
-    }
-    if (iterator->IsValid()) {
-      int cmp = iterator->Compare(&k);
-      if (cmp > 0 && iterator->reverse) {
-        iterator->SeekToFirst();
-        if (iterator->IsValid())
-          iterator->Prev();
-      } else if (cmp < 0 && !iterator->reverse) {
-        iterator->SeekToLast();
-        if (iterator->IsValid())
-          iterator->Next();
-      }
-    }
-  }
+  iterator->Unpark();
+  iterator->Reposition();
+  iterator->SeekTo(&k);
+  iterator->SavePosition();
+  iterator->Park();
+  iterator->UnlockRead();
 
   info.GetReturnValue().Set(info.Holder());
 }
@@ -292,20 +842,20 @@ NAN_METHOD(Iterator::Next) {
     LD_RETURN_CALLBACK_OR_ERROR(callback, "cannot call next() after end()")
   }
 
-  if (iterator->nexting) {
+  if (iterator->prefetchWaiting != NULL
+      || (iterator->nexting && !iterator->prefetching)) {
     LD_RETURN_CALLBACK_OR_ERROR(callback, "cannot call next() before previous next() has completed")
   }
 
-  NextWorker* worker = new NextWorker(
-      iterator
-    , new Nan::Callback(callback)
-    , checkEndCallback
-  );
-  // persist to prevent accidental GC
-  v8::Local<v8::Object> _this = info.This();
-  worker->SaveToPersistent("iterator", _this);
-  iterator->nexting = true;
-  Nan::AsyncQueueWorker(worker);
+  if (iterator->prefetched) {
+    Nan::Callback prefetched(callback);
+    iterator->DeliverPrefetched(&prefetched);
+  } else if (iterator->prefetching) {
+    // handed over by PrefetchDone()
+    iterator->prefetchWaiting = new Nan::Callback(callback);
+  } else {
+    iterator->QueueNext(new Nan::Callback(callback), false);
+  }
 
   info.GetReturnValue().Set(info.Holder());
 }
@@ -518,10 +1068,22 @@ NAN_METHOD(Iterator::New) {
   bool keyAsBuffer = BooleanOptionValue(optionsObj, "keyAsBuffer", true);
   bool valueAsBuffer = BooleanOptionValue(optionsObj, "valueAsBuffer", true);
   bool fillCache = BooleanOptionValue(optionsObj, "fillCache");
+  // checked by Database::Iterator()
+  MDB_dbi dbi;
+  database->ResolveDbi(SubDbOptionValue(optionsObj), database->dbi, dbi);
+  uint32_t refreshMs = UInt32OptionValue(optionsObj, "refreshMs", 0);
+  uint32_t refreshEntries = UInt32OptionValue(optionsObj, "refreshEntries", 0);
+  size_t prefetchBytes = UInt64OptionValue(optionsObj, "prefetchBytes", 0);
+  // both checked by Database::Iterator()
+  std::vector< Filter > filters;
+  ParseFilters(optionsObj, &filters);
+  v8::Local<v8::Object> snapshotHandle;
+  Snapshot* snapshot = SnapshotOptionValue(optionsObj, snapshotHandle);
 
   Iterator* iterator = new Iterator(
       database
     , (uint32_t)id->Int32Value()
+    , dbi
     , start
     , end
     , reverse
@@ -536,6 +1098,12 @@ NAN_METHOD(Iterator::New) {
     , keyAsBuffer
     , valueAsBuffer
     , highWaterMark
+    , refreshMs
+    , refreshEntries
+    , prefetchBytes
+    , filters
+    , snapshot
+    , snapshotHandle
   );
   iterator->Wrap(info.This());
 
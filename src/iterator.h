@@ -13,12 +13,42 @@
 #include "leveldown.h"
 #include "database.h"
 #include "async.h"
+#include "filter.h"
 
 namespace leveldown {
 
 class Database;
+class Snapshot;
 class AsyncWorker;
 
+/*
+ * A batch of entries handed to JS as a single Buffer: keys & values packed
+ * back to back, followed by a table of 2n+1 little-endian uint32 offsets
+ * (entry i's key spans [off[2i], off[2i+1]), its value
+ * [off[2i+1], off[2i+2])) and finally the entry count n. See iterator.js.
+ */
+class SlabBatch {
+public:
+  SlabBatch ();
+  ~SlabBatch ();
+
+  bool Append (const MDB_val& key, const MDB_val& value);
+  bool Finish ();
+  char* Release ();
+
+  size_t Count () const { return (offsets.size() - 1) / 2; }
+
+  char* data;
+  size_t size;
+
+private:
+  size_t capacity;
+  std::vector< uint32_t > offsets;
+
+  bool Reserve (size_t more);
+  void PutUInt32 (uint32_t value);
+};
+
 class Iterator : public Nan::ObjectWrap {
 public:
   static void Init ();
@@ -31,6 +61,7 @@ public:
   Iterator (
       Database* database
     , uint32_t id
+    , MDB_dbi dbi
     , MDB_val* start
     , MDB_val* end
     , bool reverse
@@ -45,14 +76,31 @@ public:
     , bool keyAsBuffer
     , bool valueAsBuffer
     , size_t highWaterMark
+    , uint32_t refreshMs
+    , uint32_t refreshEntries
+    , size_t prefetchBytes
+    , const std::vector< Filter >& filters
+    , Snapshot* snapshot
+    , v8::Local<v8::Object> snapshotHandle
   );
 
   ~Iterator ();
 
-  bool IteratorNext (std::vector<std::pair<std::string, std::string> >& result);
+  bool IteratorNext (SlabBatch& batch, bool prefetch, uint32_t generation);
   void IteratorEnd ();
   void Release ();
 
+  // called in the main thread, see Prefetch()
+  void Prefetch (bool finished);
+  void PrefetchDone (
+      char* slab
+    , size_t size
+    , size_t entries
+    , bool finished
+    , const char* error
+    , uint32_t generation
+  );
+
   int Compare (MDB_val* b);
   int CompareRev (MDB_val* a);
   void Seek (MDB_val* k);
@@ -65,6 +113,7 @@ public:
 private:
   Database* database;
   uint32_t id;
+  MDB_dbi dbi;
   MDB_txn     *txn;
   MDB_cursor  *cursor;
   MDB_val* start;
@@ -81,7 +130,52 @@ private:
   MDB_val* gt;
   MDB_val* gte;
   int count;
+  // all must match for an entry to be read, see Read()
+  std::vector< Filter > filters;
   size_t highWaterMark;
+  // see Reposition()
+  uint32_t mapGeneration;
+  std::string lastKey;
+  // renew the txn this often, 0 for never, see Refresh()
+  uint32_t refreshMs;
+  uint32_t refreshEntries;
+  uint64_t refreshedAt;
+  uint32_t sinceRefresh;
+  // the txn is reset between batches, see Park()
+  bool parked;
+  bool parkedPositioned;
+  bool parkedExhausted;
+  // reading from a snapshot's txn rather than one of our own
+  Snapshot* snapshot;
+  Nan::Persistent<v8::Object> snapshotHandle;
+  // the cursor is shared by the main thread (seek()) & a NextWorker
+  uv_mutex_t cursorMutex;
+  // the txn & cursor have been set up, see Open()
+  bool opened;
+  // guards seekPending, pendingSeek & seekGeneration, which seek() sets
+  // without waiting on cursorMutex; only ever held briefly
+  uv_mutex_t seekMutex;
+  // a seek() left for the next read, see Seek()
+  bool seekPending;
+  std::string pendingSeek;
+  // the pending seek the read in flight is making
+  std::string seekKey;
+  // read the next batch ahead, up to this many bytes, 0 for not at all
+  size_t prefetchBytes;
+  // the NextWorker in flight is reading ahead, rather than for a next()
+  bool prefetching;
+  // bumped by each seek(), a read ahead queued before one is no use
+  uint32_t seekGeneration;
+  // what it read, until next() takes it
+  bool prefetched;
+  char* prefetchSlab;
+  size_t prefetchSize;
+  // toward `count`, given back if it's discarded
+  size_t prefetchEntries;
+  bool prefetchFinished;
+  std::string prefetchError;
+  // a next() waiting on it
+  Nan::Callback* prefetchWaiting;
 
 public:
   bool keyAsBuffer;
@@ -94,8 +188,23 @@ public:
   AsyncWorker* endWorker;
 
 private:
-  bool Read (std::string& key, std::string& value);
+  bool Read (MDB_val& key, MDB_val& value);
+  bool ReadBatch (SlabBatch& batch, size_t bytes);
   bool GetIterator ();
+  void Reposition ();
+  void SavePosition ();
+  void Open ();
+  int LockRead ();
+  bool TryLockRead ();
+  void UnlockRead ();
+  void SeekTo (MDB_val* k);
+  void DeliverPrefetched (Nan::Callback* callback);
+  void DiscardPrefetched ();
+  void QueueNext (Nan::Callback* callback, bool prefetch);
+  bool RefreshDue ();
+  void Refresh ();
+  void Park ();
+  void Unpark ();
 
   static NAN_METHOD(New);
   static NAN_METHOD(Seek);
@@ -3,6 +3,7 @@
  * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
  */
 
+#include <errno.h>
 #include <node.h>
 #include <node_buffer.h>
 
@@ -19,15 +20,21 @@ NextWorker::NextWorker (
     Iterator* iterator
   , Nan::Callback *callback
   , void (*localCallback)(Iterator*)
+  , bool prefetch
+  , uint32_t generation
 ) : AsyncWorker(NULL, callback)
   , iterator(iterator)
   , localCallback(localCallback)
+  , prefetch(prefetch)
+  , generation(generation)
 {};
 
 NextWorker::~NextWorker () {}
 
 void NextWorker::Execute () {
-  ok = iterator->IteratorNext(result);
+  ok = iterator->IteratorNext(batch, prefetch, generation);
+  if (!batch.Finish())
+    iterator->rc = ENOMEM;
   SetStatus(iterator->rc);
 }
 
@@ -42,49 +49,52 @@ void NextWorker::WorkComplete () {
 
 void NextWorker::HandleOKCallback () {
   Nan::HandleScope scope;
-  size_t idx = 0;
-
-  size_t arraySize = result.size() * 2;
-  v8::Local<v8::Array> returnArray = Nan::New<v8::Array>(arraySize);
-
-  for(idx = 0; idx < result.size(); ++idx) {
-    std::pair<std::string, std::string> row = result[idx];
-    std::string key = row.first;
-    std::string value = row.second;
-
-    v8::Local<v8::Value> returnKey;
-    if (iterator->keyAsBuffer) {
-      //TODO: use NewBuffer, see database_async.cc
-      returnKey = Nan::CopyBuffer((char*)key.data(), key.size()).ToLocalChecked();
-    } else {
-      returnKey = Nan::New<v8::String>((char*)key.data(), key.size()).ToLocalChecked();
-    }
-
-    v8::Local<v8::Value> returnValue;
-    if (iterator->valueAsBuffer) {
-      //TODO: use NewBuffer, see database_async.cc
-      returnValue = Nan::CopyBuffer((char*)value.data(), value.size()).ToLocalChecked();
-    } else {
-      returnValue = Nan::New<v8::String>((char*)value.data(), value.size()).ToLocalChecked();
-    }
-
-    // put the key & value in a descending order, so that they can be .pop:ed in javascript-land
-    returnArray->Set(Nan::New<v8::Integer>(static_cast<int>(arraySize - idx * 2 - 1)), returnKey);
-    returnArray->Set(Nan::New<v8::Integer>(static_cast<int>(arraySize - idx * 2 - 2)), returnValue);
-  }
+
+  // the whole batch goes over as one Buffer, which takes ownership of the
+  // slab, iterator.js slices keys & values out of it
+  size_t size = batch.size;
+  size_t entries = batch.Count();
+  char* slab = batch.Release();
 
   // clean up & handle the next/end state see iterator.cc/checkEndCallback
   localCallback(iterator);
 
+  if (prefetch) {
+    iterator->PrefetchDone(slab, size, entries, !ok, NULL, generation);
+    return;
+  }
+
+  v8::Local<v8::Value> returnSlab =
+      Nan::NewBuffer(slab, size).ToLocalChecked();
+
+  // start on the next batch while JS is busy with this one
+  iterator->Prefetch(!ok);
+
   v8::Local<v8::Value> argv[] = {
       Nan::Null()
-    , returnArray
+    , returnSlab
     // when ok === false all data has been read, so it's then finished
     , Nan::New<v8::Boolean>(!ok)
   };
   callback->Call(3, argv);
 }
 
+void NextWorker::HandleErrorCallback () {
+  Nan::HandleScope scope;
+
+  localCallback(iterator);
+
+  if (prefetch) {
+    iterator->PrefetchDone(NULL, 0, batch.Count(), true, ErrorMessage(), generation);
+    return;
+  }
+
+  v8::Local<v8::Value> argv[] = {
+      Nan::Error(ErrorMessage())
+  };
+  callback->Call(1, argv);
+}
+
 /** END WORKER **/
 
 EndWorker::EndWorker (
@@ -20,17 +20,24 @@ public:
       Iterator* iterator
     , Nan::Callback *callback
     , void (*localCallback)(Iterator*)
+    , bool prefetch
+    , uint32_t generation
   );
 
   virtual ~NextWorker ();
   virtual void Execute ();
   virtual void HandleOKCallback ();
+  virtual void HandleErrorCallback ();
   virtual void WorkComplete ();
 
 private:
   Iterator* iterator;
   void (*localCallback)(Iterator*);
-  std::vector<std::pair<std::string, std::string> > result;
+  // reading ahead, no `callback`, see Iterator::Prefetch()
+  bool prefetch;
+  // the iterator's seekGeneration when queued
+  uint32_t generation;
+  SlabBatch batch;
   bool ok;
 };
 
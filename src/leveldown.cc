@@ -9,6 +9,8 @@
 #include "database.h"
 #include "iterator.h"
 #include "batch.h"
+#include "builder.h"
+#include "snapshot.h"
 #include "leveldown_async.h"
 
 namespace leveldown {
@@ -53,6 +55,8 @@ void Init (v8::Local<v8::Object> target) {
   Database::Init();
   leveldown::Iterator::Init();
   leveldown::WriteBatch::Init();
+  leveldown::Builder::Init();
+  leveldown::Snapshot::Init();
 
   v8::Local<v8::Function> leveldown =
       Nan::New<v8::FunctionTemplate>(LevelDOWN)->GetFunction();
@@ -67,6 +71,11 @@ void Init (v8::Local<v8::Object> target) {
     , Nan::New<v8::FunctionTemplate>(RepairDB)->GetFunction()
   );
 
+  leveldown->Set(
+      Nan::New("builder").ToLocalChecked()
+    , Nan::New<v8::FunctionTemplate>(NewBuilder)->GetFunction()
+  );
+
   target->Set(Nan::New("leveldown").ToLocalChecked(), leveldown);
 }
 
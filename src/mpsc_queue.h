@@ -0,0 +1,77 @@
+/* Copyright (c) 2012-2016 LevelDOWN contributors
+ * See list at <https://github.com/level/leveldown#contributing>
+ * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
+ */
+
+#ifndef LD_MPSC_QUEUE_H
+#define LD_MPSC_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+
+namespace leveldown {
+
+struct QueueNode {
+  QueueNode () : queueNext(NULL) {}
+
+  std::atomic<QueueNode*> queueNext;
+};
+
+/*
+ * Intrusive, lock-free, multi-producer single-consumer queue (Dmitry
+ * Vyukov's design). Push() may be called from any thread, Pop() only ever
+ * from the one consuming thread. A node may only sit in one queue at a
+ * time.
+ */
+class MPSCQueue {
+public:
+  MPSCQueue () : head(&stub), tail(&stub) {}
+
+  void Push (QueueNode* node) {
+    node->queueNext.store(NULL, std::memory_order_relaxed);
+    QueueNode* prev = head.exchange(node, std::memory_order_acq_rel);
+    prev->queueNext.store(node, std::memory_order_release);
+  }
+
+  // NOTE: may return NULL while a Push() is half way through linking its
+  // node, producers must signal the consumer *after* Push() returns
+  QueueNode* Pop () {
+    QueueNode* node = tail;
+    QueueNode* next = node->queueNext.load(std::memory_order_acquire);
+
+    if (node == &stub) {
+      if (next == NULL)
+        return NULL;
+      tail = next;
+      node = next;
+      next = next->queueNext.load(std::memory_order_acquire);
+    }
+
+    if (next != NULL) {
+      tail = next;
+      return node;
+    }
+
+    if (node != head.load(std::memory_order_acquire))
+      return NULL;
+
+    Push(&stub);
+
+    next = node->queueNext.load(std::memory_order_acquire);
+    if (next != NULL) {
+      tail = next;
+      return node;
+    }
+
+    return NULL;
+  }
+
+private:
+  std::atomic<QueueNode*> head;
+  QueueNode* tail;
+  QueueNode stub;
+};
+
+} // namespace leveldown
+
+#endif
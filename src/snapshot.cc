@@ -0,0 +1,220 @@
+/* Copyright (c) 2012-2016 LevelDOWN contributors
+ * See list at <https://github.com/level/leveldown#contributing>
+ * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
+ */
+
+#include <node.h>
+#include <nan.h>
+
+#include "database.h"
+#include "snapshot.h"
+
+namespace leveldown {
+
+static Nan::Persistent<v8::FunctionTemplate> snapshot_constructor;
+
+Snapshot::Snapshot (Database* database, SharedEnv* sharedEnv, MDB_txn* txn)
+  : database(database)
+  , sharedEnv(sharedEnv)
+  , txn(txn)
+  , pending(txn == NULL)
+  , closePending(false)
+  , iterators(0)
+  , released(false)
+{
+  uv_mutex_init(&mutex);
+  uv_mutex_init(&closeMutex);
+};
+
+Snapshot::~Snapshot () {
+  // garbage collected without release(), reads hold a handle on us so
+  // none can still be using the txn
+  Close();
+  uv_mutex_destroy(&mutex);
+  uv_mutex_destroy(&closeMutex);
+};
+
+int Snapshot::Lock (MDB_txn **txn) {
+  uv_mutex_lock(&mutex);
+  return Acquire(txn);
+}
+
+int Snapshot::TryLock (MDB_txn **txn) {
+  if (uv_mutex_trylock(&mutex) != 0)
+    return EBUSY;
+  return Acquire(txn);
+}
+
+// with `mutex` just taken, which is let go of (see Unlock()) on an error
+int Snapshot::Acquire (MDB_txn **txn) {
+  if (pending && sharedEnv != NULL) {
+    // a resize had the map when snapshot() was called; the caller holds
+    // the map lock now
+    int rc = BeginSnapshotTxn(sharedEnv->env, &this->txn);
+    if (rc != 0) {
+      this->txn = NULL;
+      Unlock();
+      return rc;
+    }
+    pending = false;
+  }
+
+  *txn = this->txn;
+
+  if (*txn == NULL) {
+    // released while the read was queued
+    Unlock();
+    return MDB_BAD_TXN;
+  }
+
+  return 0;
+}
+
+void Snapshot::Unlock () {
+  SharedEnv* closed = NULL;
+
+  uv_mutex_lock(&closeMutex);
+  if (closePending) {
+    closePending = false;
+    closed = CloseTxn();
+  }
+  uv_mutex_unlock(&mutex);
+  uv_mutex_unlock(&closeMutex);
+
+  if (closed != NULL)
+    ReleaseEnv(closed);
+}
+
+int Snapshot::OpenCursor (MDB_dbi dbi, MDB_cursor **cursor) {
+  for (std::vector< MDB_cursor* >::iterator it = cursors.begin()
+      ; it != cursors.end()
+      ; ++it) {
+    if (mdb_cursor_dbi(*it) == dbi) {
+      *cursor = *it;
+      cursors.erase(it);
+      // unpositioned, it may have been left on pages since remapped
+      return mdb_cursor_renew(txn, *cursor);
+    }
+  }
+
+  return mdb_cursor_open(txn, dbi, cursor);
+}
+
+void Snapshot::CloseCursor (MDB_cursor *cursor) {
+  if (cursors.size() < READ_POOL_MAX)
+    cursors.push_back(cursor);
+  else
+    mdb_cursor_close(cursor);
+}
+
+void Snapshot::Unref () {
+  if (--iterators == 0 && released)
+    Close();
+}
+
+/*
+ * Gives up the txn & the env it holds open. Called in the main thread,
+ * which mustn't wait on a read (a whole-range aggregate() holds the txn
+ * throughout), so if one has it the read closes it on Unlock() instead.
+ */
+void Snapshot::Close () {
+  SharedEnv* closed = NULL;
+
+  uv_mutex_lock(&closeMutex);
+  if (uv_mutex_trylock(&mutex) == 0) {
+    closed = CloseTxn();
+    uv_mutex_unlock(&mutex);
+  } else {
+    closePending = true;
+  }
+  uv_mutex_unlock(&closeMutex);
+
+  if (closed != NULL)
+    ReleaseEnv(closed);
+}
+
+// with `mutex` held, the env for the caller to release, or NULL if closed
+SharedEnv* Snapshot::CloseTxn () {
+  if (sharedEnv == NULL)
+    return NULL;
+
+  for (std::vector< MDB_cursor* >::iterator it = cursors.begin()
+      ; it != cursors.end()
+      ; ++it) {
+    mdb_cursor_close(*it);
+  }
+  cursors.clear();
+
+  if (txn != NULL)
+    mdb_txn_abort(txn);
+  txn = NULL;
+  pending = false;
+
+  SharedEnv* closed = sharedEnv;
+  sharedEnv = NULL;
+  return closed;
+}
+
+void Snapshot::Init () {
+  v8::Local<v8::FunctionTemplate> tpl = Nan::New<v8::FunctionTemplate>(Snapshot::New);
+  snapshot_constructor.Reset(tpl);
+  tpl->SetClassName(Nan::New("Snapshot").ToLocalChecked());
+  tpl->InstanceTemplate()->SetInternalFieldCount(1);
+  Nan::SetPrototypeMethod(tpl, "release", Snapshot::Release);
+}
+
+bool Snapshot::HasInstance (v8::Local<v8::Value> value) {
+  return value->IsObject()
+    && Nan::New<v8::FunctionTemplate>(snapshot_constructor)->HasInstance(value);
+}
+
+NAN_METHOD(Snapshot::New) {
+  Database* database = Nan::ObjectWrap::Unwrap<Database>(info[0]->ToObject());
+
+  MDB_txn* txn;
+  SharedEnv* sharedEnv;
+
+  int rc = database->BeginSnapshot(&txn, &sharedEnv);
+  if (rc)
+    return Nan::ThrowError(mdb_strerror(rc));
+
+  Snapshot* snapshot = new Snapshot(database, sharedEnv, txn);
+  snapshot->Wrap(info.This());
+
+  info.GetReturnValue().Set(info.This());
+}
+
+v8::Local<v8::Value> Snapshot::NewInstance (v8::Local<v8::Object> database) {
+  Nan::EscapableHandleScope scope;
+
+  Nan::MaybeLocal<v8::Object> maybeInstance;
+  v8::Local<v8::Object> instance;
+
+  v8::Local<v8::FunctionTemplate> constructorHandle =
+      Nan::New<v8::FunctionTemplate>(snapshot_constructor);
+
+  v8::Local<v8::Value> argv[1] = { database };
+  maybeInstance = Nan::NewInstance(constructorHandle->GetFunction(), 1, argv);
+
+  if (maybeInstance.IsEmpty())
+    return scope.Escape(Nan::Undefined());
+
+  instance = maybeInstance.ToLocalChecked();
+  return scope.Escape(instance);
+}
+
+// the txn goes once the last iterator on it has ended, reads queued after
+// this fail with MDB_BAD_TXN
+NAN_METHOD(Snapshot::Release) {
+  Snapshot* snapshot = Nan::ObjectWrap::Unwrap<Snapshot>(info.Holder());
+
+  if (!snapshot->released) {
+    snapshot->released = true;
+    if (snapshot->iterators == 0)
+      snapshot->Close();
+  }
+
+  info.GetReturnValue().SetUndefined();
+}
+
+} // namespace leveldown
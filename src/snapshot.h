@@ -0,0 +1,94 @@
+/* Copyright (c) 2012-2016 LevelDOWN contributors
+ * See list at <https://github.com/level/leveldown#contributing>
+ * MIT License <https://github.com/level/leveldown/blob/master/LICENSE.md>
+ */
+
+#ifndef LD_SNAPSHOT_H
+#define LD_SNAPSHOT_H
+
+#include <vector>
+#include <node.h>
+#include <nan.h>
+
+#include "database.h"
+
+namespace leveldown {
+
+/*
+ * A read txn held open on behalf of JS, see `db.snapshot()`. Gets, getMany()
+ * and iterators given it all read from the one txn, so see the same data and
+ * share a single reader slot. An LMDB txn can't be used by two threads at
+ * once, so reads on it take turns with Lock() & Unlock().
+ */
+class Snapshot : public Nan::ObjectWrap {
+public:
+  static void Init ();
+  static v8::Local<v8::Value> NewInstance (v8::Local<v8::Object> database);
+  static bool HasInstance (v8::Local<v8::Value> value);
+
+  Snapshot (Database* database, SharedEnv* sharedEnv, MDB_txn* txn);
+  ~Snapshot ();
+
+  // called from worker threads, NO V8 HERE; the txn is the caller's until
+  // Unlock(), unless an error is returned
+  int Lock (MDB_txn **txn);
+  // as Lock(), for the main thread, EBUSY rather than wait on a read
+  int TryLock (MDB_txn **txn);
+  void Unlock ();
+  // with the lock held
+  int OpenCursor (MDB_dbi dbi, MDB_cursor **cursor);
+  void CloseCursor (MDB_cursor *cursor);
+
+  // called in the main thread, open iterators keep the txn from being
+  // released under them
+  void Ref () { iterators++; }
+  void Unref ();
+
+  bool IsReleased () const { return released; }
+
+  // the Database it was taken from, only ever compared against
+  Database* database;
+
+private:
+  SharedEnv* sharedEnv;
+  MDB_txn* txn;
+  // the txn is yet to be begun, by the first Lock()
+  bool pending;
+  uv_mutex_t mutex;
+  // guards closePending, only ever held briefly
+  uv_mutex_t closeMutex;
+  // Close() found a read on the txn, which is left to close it
+  bool closePending;
+  // closed cursors, kept open for reuse
+  std::vector< MDB_cursor* > cursors;
+  int iterators;
+  bool released;
+
+  int Acquire (MDB_txn **txn);
+  void Close ();
+  SharedEnv* CloseTxn ();
+
+  static NAN_METHOD(New);
+  static NAN_METHOD(Release);
+};
+
+// the Snapshot given as `snapshot` in `options`, or NULL
+static inline Snapshot* SnapshotOptionValue (
+      v8::Local<v8::Object> options
+    , v8::Local<v8::Object>& handle) {
+  v8::Local<v8::String> key = Nan::New("snapshot").ToLocalChecked();
+
+  if (options.IsEmpty() || !options->Has(key))
+    return NULL;
+
+  v8::Local<v8::Value> value = options->Get(key);
+  if (!Snapshot::HasInstance(value))
+    return NULL;
+
+  handle = value.As<v8::Object>();
+  return Nan::ObjectWrap::Unwrap<Snapshot>(handle);
+}
+
+} // namespace leveldown
+
+#endif
@@ -0,0 +1,180 @@
+const util              = require('util')
+    , AbstractLevelDOWN = require('abstract-leveldown').AbstractLevelDOWN
+
+    , ChainedBatch      = require('./chained-batch')
+    , Iterator          = require('./iterator')
+    , packBatch         = require('./packed-batch')
+    , ValueStream       = require('./value-stream')
+
+
+// A named sub-database: a keyspace with an MDB_dbi of its own, living in
+// (and sharing txns with) its parent's environment. Everything goes through
+// the parent's binding, tagged with `subdb: this` to pick the dbi by `id`
+function SubDB (db, name, options, id) {
+  AbstractLevelDOWN.call(this, name)
+
+  this.db      = db
+  this.binding = db.binding
+  // already opened by subdb() with a callback
+  this.id      = id !== undefined ? id : db.binding.subdb(name, options)
+}
+
+util.inherits(SubDB, AbstractLevelDOWN)
+
+
+SubDB.prototype._tag = function (options) {
+  var tagged = {}
+
+  for (var k in options)
+    tagged[k] = options[k]
+  tagged.subdb = this
+
+  return tagged
+}
+
+
+// opened along with its parent
+SubDB.prototype._open = function (options, callback) {
+  process.nextTick(callback)
+}
+
+
+SubDB.prototype._close = function (callback) {
+  process.nextTick(callback)
+}
+
+
+SubDB.prototype._put = function (key, value, options, callback) {
+  this.binding.put(key, value, this._tag(options), callback)
+}
+
+
+SubDB.prototype.putParts = function (key, parts, options, callback) {
+  if (typeof options == 'function') {
+    callback = options
+    options  = {}
+  }
+
+  this.db.putParts(key, parts, this._tag(options), callback)
+}
+
+
+SubDB.prototype._get = function (key, options, callback) {
+  this.binding.get(key, this._tag(options), callback)
+}
+
+
+SubDB.prototype.getMany = function (keys, options, callback) {
+  if (typeof options == 'function') {
+    callback = options
+    options  = {}
+  }
+
+  this.db.getMany(keys, this._tag(options), callback)
+}
+
+
+SubDB.prototype.getRange = function (key, offset, length, options, callback) {
+  if (typeof options == 'function') {
+    callback = options
+    options  = {}
+  }
+
+  this.db.getRange(key, offset, length, this._tag(options), callback)
+}
+
+
+SubDB.prototype.releaseBuffer = function (buffer) {
+  return this.db.releaseBuffer(buffer)
+}
+
+
+SubDB.prototype.createValueStream = function (key, options) {
+  return new ValueStream(this, key, options, this.db._valueStreamMode(options))
+}
+
+
+SubDB.prototype._del = function (key, options, callback) {
+  this.binding.del(key, this._tag(options), callback)
+}
+
+
+SubDB.prototype._chainedBatch = function () {
+  return new ChainedBatch(this, { subdb: this })
+}
+
+
+SubDB.prototype.batch = packBatch.batch
+
+
+// ops without a `subdb` of their own are for this one
+SubDB.prototype._batch = function (operations, options, callback) {
+  return this.binding.batch(operations, this._tag(options), callback)
+}
+
+
+SubDB.prototype._approximateSize = function (start, end, callback) {
+  this.binding.approximateSize(start, end, this._tag({}), callback)
+}
+
+
+SubDB.prototype.aggregate = function (options, callback) {
+  if (typeof callback != 'function')
+    throw new Error('aggregate() requires a callback argument')
+
+  this.binding.aggregate(this._tag(options), callback)
+}
+
+
+SubDB.prototype.clear = function (options, callback) {
+  if (typeof options == 'function') {
+    callback = options
+    options  = {}
+  }
+
+  if (typeof callback != 'function')
+    throw new Error('clear() requires a callback argument')
+
+  this.binding.clear(this._tag(options), callback)
+}
+
+
+SubDB.prototype.delRange = function (options, callback) {
+  if (typeof options == 'function') {
+    callback = options
+    options  = {}
+  }
+
+  if (typeof callback != 'function')
+    throw new Error('delRange() requires a callback argument')
+
+  this.binding.delRange(this._tag(options), callback)
+}
+
+
+// empties the sub-db & forgets it, no handle on it can be used afterwards
+SubDB.prototype.drop = function (options, callback) {
+  if (typeof options == 'function') {
+    callback = options
+    options  = {}
+  }
+
+  if (typeof callback != 'function')
+    throw new Error('drop() requires a callback argument')
+
+  this.binding.drop(this._tag(options), callback)
+}
+
+
+SubDB.prototype._iterator = function (options) {
+  return new Iterator(this, this._tag(options))
+}
+
+
+// of the whole environment, it can be used with the parent & other sub-dbs
+SubDB.prototype.snapshot = function () {
+  return this.db.snapshot()
+}
+
+
+module.exports = SubDB
@@ -0,0 +1,121 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+// value: an int32le count, then a doublele reading
+function value (count, reading) {
+  var v = new Buffer(12)
+  v.writeInt32LE(count, 0)
+  v.writeDoubleLE(reading, 4)
+  return v
+}
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    db.batch([
+        { type: 'put', key: 't:01', value: value(3, 1.5) }
+      , { type: 'put', key: 't:02', value: value(-7, 2.25) }
+      , { type: 'put', key: 't:03', value: value(10, -0.5) }
+      , { type: 'put', key: 't:04', value: value(4, 8) }
+      , { type: 'put', key: 'u', value: 'abc' }
+    ], t.end.bind(t))
+  })
+})
+
+test('test argument checking', function (t) {
+  t.throws(db.aggregate.bind(db, { op: 'count' }), /requires a callback/)
+  db.aggregate({ op: 'avg' }, function (err) {
+    t.ok(/requires an op/.test(err && err.message), 'unknown op')
+    db.aggregate({ op: 'sum' }, function (err) {
+      t.ok(/requires a field/.test(err && err.message), 'no field')
+      db.aggregate({ op: 'sum', field: { type: 'int24' } }, function (err) {
+        t.ok(/unknown field type/.test(err && err.message), 'bad field')
+        t.end()
+      })
+    })
+  })
+})
+
+test('test count', function (t) {
+  db.aggregate({ op: 'count' }, function (err, result) {
+    t.notOk(err, 'no error')
+    t.equal(result, 5, 'every entry')
+    db.aggregate({ op: 'count', field: { offset: 4, type: 'doublele' } }, function (err, result) {
+      t.notOk(err, 'no error')
+      t.equal(result, 4, 'only those holding the field')
+      t.end()
+    })
+  })
+})
+
+test('test sum, min & max of integers', function (t) {
+  var field = { offset: 0, type: 'int32le' }
+  db.aggregate({ op: 'sum', field: field }, function (err, result, count) {
+    t.notOk(err, 'no error')
+    t.equal(result, 10, 'sum')
+    t.equal(count, 4, 'count')
+    db.aggregate({ op: 'min', field: field }, function (err, result) {
+      t.notOk(err, 'no error')
+      t.equal(result, -7, 'min')
+      db.aggregate({ op: 'max', field: field, lt: 't:03' }, function (err, result) {
+        t.notOk(err, 'no error')
+        t.equal(result, 3, 'max within a range')
+        t.end()
+      })
+    })
+  })
+})
+
+test('test sum, min & max of doubles', function (t) {
+  var field = { offset: 4, type: 'doublele' }
+  db.aggregate({ op: 'sum', field: field, gt: 't:01', lte: 't:03' }, function (err, result) {
+    t.notOk(err, 'no error')
+    t.equal(result, 1.75, 'sum within a range')
+    db.aggregate({ op: 'min', field: field }, function (err, result) {
+      t.notOk(err, 'no error')
+      t.equal(result, -0.5, 'min')
+      db.aggregate({ op: 'max', field: field, filter: { field: { offset: 0, type: 'int32le' }, lt: 5 } }, function (err, result) {
+        t.notOk(err, 'no error')
+        t.equal(result, 8, 'max of those filtered')
+        t.end()
+      })
+    })
+  })
+})
+
+test('test an empty range', function (t) {
+  var field = { offset: 0, type: 'int32le' }
+  db.aggregate({ op: 'max', field: field, gte: 'v' }, function (err, result, count) {
+    t.notOk(err, 'no error')
+    t.equal(result, undefined, 'no max')
+    t.equal(count, 0, 'count')
+    db.aggregate({ op: 'sum', field: field, gte: 'v' }, function (err, result) {
+      t.notOk(err, 'no error')
+      t.equal(result, 0, 'sum of nothing')
+      t.end()
+    })
+  })
+})
+
+test('test aggregate on a snapshot', function (t) {
+  var snapshot = db.snapshot()
+  db.del('t:04', function (err) {
+    t.notOk(err, 'no error')
+    db.aggregate({ op: 'count', snapshot: snapshot }, function (err, result) {
+      t.notOk(err, 'no error')
+      t.equal(result, 5, 'the delete isn\'t seen')
+      snapshot.release()
+      t.end()
+    })
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
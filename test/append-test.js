@@ -0,0 +1,113 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+function key (i) {
+  return 'k' + ('00000' + i).slice(-5)
+}
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open({ mapSize: 64 << 20 }, t.end.bind(t))
+})
+
+test('test put() with append', function (t) {
+  db.put(key(0), 'a', { append: true }, function (err) {
+    t.notOk(err, 'no error')
+    db.put(key(1), 'b', { append: true }, function (err) {
+      t.notOk(err, 'no error')
+      db.put(key(1), 'c', { append: true }, function (err) {
+        t.ok(err, 'same key fails')
+        t.ok(/MDB_KEYEXIST/.test(err.message), 'with MDB_KEYEXIST')
+        db.get(key(1), { asBuffer: false }, function (err, value) {
+          t.notOk(err, 'no error')
+          t.equal(value, 'b', 'not overwritten')
+          t.end()
+        })
+      })
+    })
+  })
+})
+
+test('test batch() with append', function (t) {
+  var ops = []
+  for (var i = 2; i < 1000; i++)
+    ops.push({ type: 'put', key: key(i), value: 'v' + i })
+
+  db.batch(ops, { append: true }, function (err) {
+    t.notOk(err, 'no error')
+    db.get(key(999), { asBuffer: false }, function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value, 'v999')
+      t.end()
+    })
+  })
+})
+
+test('test batch() with append out of order', function (t) {
+  db.batch([
+      { type: 'put', key: key(2000), value: 'x' }
+    , { type: 'put', key: key(1500), value: 'y' }
+  ], { append: true }, function (err) {
+    t.ok(err, 'fails')
+    t.ok(/MDB_KEYEXIST/.test(err.message), 'with MDB_KEYEXIST')
+    db.get(key(2000), function (err) {
+      t.ok(err, 'nothing written')
+      t.end()
+    })
+  })
+})
+
+test('test batch() with commitBytes commits in pieces', function (t) {
+  var ops = []
+    , value = new Buffer(1000)
+
+  value.fill('v')
+  for (var i = 1000; i < 2000; i++)
+    ops.push({ type: 'put', key: key(i), value: value })
+
+  db.batch(ops, { append: true, commitBytes: 16 * 1024 }, function (err) {
+    t.notOk(err, 'no error')
+    var it = db.iterator({ gte: key(1000), values: false, keyAsBuffer: false })
+      , count = 0
+
+    function next () {
+      it.next(function (err, k) {
+        t.notOk(err, 'no error')
+        if (k === undefined) {
+          t.equal(count, 1000, 'all written')
+          return it.end(t.end.bind(t))
+        }
+        count++
+        next()
+      })
+    }
+    next()
+  })
+})
+
+test('test a failing chunked batch keeps committed pieces', function (t) {
+  var ops = []
+    , value = new Buffer(1000)
+
+  value.fill('v')
+  for (var i = 3000; i < 3100; i++)
+    ops.push({ type: 'put', key: key(i), value: value })
+  ops.push({ type: 'put', key: key(2500), value: value })
+
+  db.batch(ops, { append: true, commitBytes: 16 * 1024 }, function (err) {
+    t.ok(err, 'fails')
+    db.get(key(3000), function (err) {
+      t.notOk(err, 'first piece was committed')
+      t.end()
+    })
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
@@ -0,0 +1,84 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+  , value = new Buffer(4000).fill('x')
+
+function key (i) {
+  return 'key' + ('00000' + i).slice(-5)
+}
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open({ mapSize: 256 << 20 }, function (err) {
+    t.notOk(err, 'no error')
+
+    var ops = []
+    for (var i = 0; i < 10000; i++)
+      ops.push({ type: 'put', key: key(i), value: value })
+    db.batch(ops, t.end.bind(t))
+  })
+})
+
+test('test approximateSize() of a small range is exact', function (t) {
+  db.approximateSize(key(10), key(12), function (err, size, info) {
+    t.notOk(err, 'no error')
+    t.equal(info.exact, true, 'exact')
+    // in page bytes, each value having an overflow page of its own
+    t.ok(size >= 3 * (8 + value.length), 'at least the keys & values: ' + size)
+    t.ok(size <= 3 * (8 + 4096 + 64), 'no more than their pages: ' + size)
+    t.end()
+  })
+})
+
+test('test approximateSize() exact & estimated sizes are comparable', function (t) {
+  db.approximateSize(key(10), key(12), function (err, exact) {
+    t.notOk(err, 'no error')
+    db.approximateSize(key(10), key(5010), function (err, estimate, info) {
+      t.notOk(err, 'no error')
+      t.equal(info.exact, false, 'not exact')
+      var ratio = (estimate / 5001) / (exact / 3)
+      t.ok(ratio > 0.8 && ratio < 1.25, 'per entry, about the same: ' + ratio)
+      t.end()
+    })
+  })
+})
+
+test('test approximateSize() stops at the end', function (t) {
+  db.approximateSize(key(10), key(10) + '!', function (err, one) {
+    t.notOk(err, 'no error')
+    db.approximateSize(key(10), key(11), function (err, two) {
+      t.notOk(err, 'no error')
+      t.equal(two, 2 * one, 'the next key isn\'t counted until it\'s the end')
+      t.end()
+    })
+  })
+})
+
+test('test approximateSize() of a wide range is estimated', function (t) {
+  var actual = 5000 * (8 + value.length)
+
+  db.approximateSize(key(2500), key(7500), function (err, size, info) {
+    t.notOk(err, 'no error')
+    t.equal(info.exact, false, 'not exact')
+    t.equal(typeof info.error, 'number', 'has an error bound')
+    t.ok(size > actual * 0.8 && size < actual * 1.25, 'size is close: ' + size)
+    t.end()
+  })
+})
+
+test('test approximateSize() of an empty range', function (t) {
+  db.approximateSize('zz', 'zzz', function (err, size, info) {
+    t.notOk(err, 'no error')
+    t.equal(size, 0, 'zero size')
+    t.equal(info.exact, true, 'exact')
+    t.end()
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
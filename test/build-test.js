@@ -0,0 +1,153 @@
+const test       = require('tape')
+    , fs         = require('fs')
+    , path       = require('path')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+function key (i) {
+  return 'k' + ('000000' + i).slice(-6)
+}
+
+function entries (from, to) {
+  var out = []
+  for (var i = from; i < to; i++)
+    out.push({ key: key(i), value: i % 100 === 0 ? new Buffer(10000) : 'v' + i })
+  return out
+}
+
+test('setUp common', testCommon.setUp)
+
+test('test build() requires a location', function (t) {
+  t.throws(lmdb.build.bind(lmdb), /requires a location/)
+  t.end()
+})
+
+test('test build() & open', function (t) {
+  var location = testCommon.location()
+    , builder  = lmdb.build(location)
+
+  t.throws(builder.write.bind(builder, []), /requires a callback/)
+
+  builder.write(entries(0, 5000), function (err) {
+    t.notOk(err, 'no error')
+    builder.write(entries(5000, 20000), function (err) {
+      t.notOk(err, 'no error')
+      builder.finish(function (err) {
+        t.notOk(err, 'no error')
+
+        var db = lmdb(location)
+        db.open(function (err) {
+          t.notOk(err, 'no error')
+          db.get(key(12345), { asBuffer: false }, function (err, value) {
+            t.notOk(err, 'no error')
+            t.equal(value, 'v12345')
+            db.get(key(300), function (err, value) {
+              t.notOk(err, 'no error')
+              t.equal(value.length, 10000, 'overflow value')
+
+              var it = db.iterator({ values: false, keyAsBuffer: false })
+                , count = 0
+                , last = ''
+                , sorted = true
+
+              function next () {
+                it.next(function (err, k) {
+                  t.error(err)
+                  if (k === undefined) {
+                    t.equal(count, 20000, 'all entries')
+                    t.ok(sorted, 'in order')
+                    return it.end(function () {
+                      db.put('zzz', 'more', function (err) {
+                        t.notOk(err, 'writable afterwards')
+                        db.close(t.end.bind(t))
+                      })
+                    })
+                  }
+                  sorted = sorted && k > last
+                  last = k
+                  count++
+                  next()
+                })
+              }
+              next()
+            })
+          })
+        })
+      })
+    })
+  })
+})
+
+test('test build() of nothing', function (t) {
+  var location = testCommon.location()
+    , builder  = lmdb.build(location)
+
+  builder.finish(function (err) {
+    t.notOk(err, 'no error')
+    var db = lmdb(location)
+    db.open(function (err) {
+      t.notOk(err, 'opens empty')
+      db.close(t.end.bind(t))
+    })
+  })
+})
+
+test('test build() reads each key & value once', function (t) {
+  var location = testCommon.location()
+    , builder  = lmdb.build(location)
+    , calls    = 0
+    // longer each time it's asked for
+    , value    = { toString: function () { return new Array(++calls * 1000).join('x') } }
+
+  builder.write([ { key: 'a', value: value } ], function (err) {
+    t.notOk(err, 'no error')
+    t.equal(calls, 1, 'converted once')
+    builder.finish(function (err) {
+      t.notOk(err, 'no error')
+      var db = lmdb(location)
+      db.open(function (err) {
+        t.notOk(err, 'no error')
+        db.get('a', function (err, got) {
+          t.notOk(err, 'no error')
+          t.equal(got.length, 999, 'as it was sized')
+          db.close(t.end.bind(t))
+        })
+      })
+    })
+  })
+})
+
+test('test build() with keys out of order', function (t) {
+  var location = testCommon.location()
+    , builder  = lmdb.build(location)
+
+  builder.write([
+      { key: 'b', value: '1' }
+    , { key: 'a', value: '2' }
+  ], function (err) {
+    t.ok(err, 'errors')
+    t.ok(/MDB_KEYEXIST/.test(err.message), 'with MDB_KEYEXIST')
+    t.notOk(fs.existsSync(path.join(location, 'data.mdb')), 'partial file removed')
+    builder.finish(function (err) {
+      t.ok(err, 'abandoned')
+      t.end()
+    })
+  })
+})
+
+test('test build() over an existing database', function (t) {
+  var location = testCommon.location()
+    , db       = lmdb(location)
+
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    db.close(function () {
+      lmdb.build(location).finish(function (err) {
+        t.ok(err, 'won\'t overwrite')
+        t.end()
+      })
+    })
+  })
+})
+
+test('tearDown', testCommon.tearDown)
@@ -0,0 +1,206 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+function fill (db, n, callback) {
+  var ops = []
+  for (var i = 0; i < n; i++)
+    ops.push({ type: 'put', key: 'k' + i, value: 'v' + i })
+  db.batch(ops, callback)
+}
+
+function count (db, callback) {
+  var it = db.iterator({ keyAsBuffer: false, valueAsBuffer: false })
+    , keys = []
+
+  function next () {
+    it.next(function (err, key) {
+      if (err || key === undefined)
+        return it.end(function () { callback(err, keys) })
+      keys.push(key)
+      next()
+    })
+  }
+  next()
+}
+
+test('setUp common', testCommon.setUp)
+
+test('test clear() requires a callback', function (t) {
+  db = lmdb(testCommon.location())
+  t.throws(db.clear.bind(db), /requires a callback/)
+  t.end()
+})
+
+test('test clear() empties the database', function (t) {
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    fill(db, 1000, function (err) {
+      t.notOk(err, 'no error')
+      db.clear(function (err) {
+        t.notOk(err, 'no error')
+        count(db, function (err, keys) {
+          t.notOk(err, 'no error')
+          t.equal(keys.length, 0, 'no entries left')
+          db.put('a', 'b', function (err) {
+            t.notOk(err, 'still writable')
+            db.close(t.end.bind(t))
+          })
+        })
+      })
+    })
+  })
+})
+
+test('test clear() and drop() of sub-dbs', function (t) {
+  db = lmdb(testCommon.location())
+  db.open({ maxDbs: 2 }, function (err) {
+    t.notOk(err, 'no error')
+    var a = db.subdb('a')
+      , b = db.subdb('b')
+
+    fill(a, 100, function (err) {
+      t.notOk(err, 'no error')
+      fill(b, 100, function (err) {
+        t.notOk(err, 'no error')
+        a.clear(function (err) {
+          t.notOk(err, 'no error')
+          count(a, function (err, keys) {
+            t.notOk(err, 'no error')
+            t.equal(keys.length, 0, 'cleared')
+            count(b, function (err, keys) {
+              t.notOk(err, 'no error')
+              t.equal(keys.length, 100, 'other sub-db untouched')
+              b.drop(function (err) {
+                t.notOk(err, 'no error')
+                b.put('x', 'y', function (err) {
+                  t.ok(err, 'dropped handle is unusable')
+                  count(db, function (err, keys) {
+                    t.notOk(err, 'no error')
+                    // the dbi isn't closed, so its (empty) record stays
+                    t.deepEqual(keys, [ 'a', 'b' ], 'the names are left')
+                    db.close(t.end.bind(t))
+                  })
+                })
+              })
+            })
+          })
+        })
+      })
+    })
+  })
+})
+
+test('test clear() of the main db keeps sub-db names', function (t) {
+  db = lmdb(testCommon.location())
+  db.open({ maxDbs: 1 }, function (err) {
+    t.notOk(err, 'no error')
+    var sub = db.subdb('sub')
+
+    fill(db, 100, function (err) {
+      t.notOk(err, 'no error')
+      sub.put('a', 'b', function (err) {
+        t.notOk(err, 'no error')
+        db.clear(function (err) {
+          t.notOk(err, 'no error')
+          count(db, function (err, keys) {
+            t.notOk(err, 'no error')
+            t.deepEqual(keys, [ 'sub' ], 'only the sub-db name left')
+            sub.get('a', { asBuffer: false }, function (err, value) {
+              t.notOk(err, 'no error')
+              t.equal(value, 'b', 'sub-db intact')
+              db.close(t.end.bind(t))
+            })
+          })
+        })
+      })
+    })
+  })
+})
+
+test('test clear() without maxDbs keeps sub-dbs made with it', function (t) {
+  var location = testCommon.location()
+  db = lmdb(location)
+  db.open({ maxDbs: 1 }, function (err) {
+    t.notOk(err, 'no error')
+    db.subdb('sub').put('a', 'b', function (err) {
+      t.notOk(err, 'no error')
+      db.close(function (err) {
+        t.notOk(err, 'no error')
+        db = lmdb(location)
+        db.open(function (err) {
+          t.notOk(err, 'no error')
+          fill(db, 10, function (err) {
+            t.notOk(err, 'no error')
+            db.clear(function (err) {
+              t.notOk(err, 'no error')
+              db.close(function (err) {
+                t.notOk(err, 'no error')
+                db = lmdb(location)
+                db.open({ maxDbs: 1 }, function (err) {
+                  t.notOk(err, 'no error')
+                  db.subdb('sub', { create: false }).get('a', { asBuffer: false }, function (err, value) {
+                    t.notOk(err, 'no error')
+                    t.equal(value, 'b', 'sub-db intact')
+                    db.close(t.end.bind(t))
+                  })
+                })
+              })
+            })
+          })
+        })
+      })
+    })
+  })
+})
+
+test('test drop() fails every handle on the sub-db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open({ maxDbs: 2 }, function (err) {
+    t.notOk(err, 'no error')
+    var one = db.subdb('same')
+      , two = db.subdb('same')
+      , other = db.subdb('other')
+
+    fill(one, 10, function (err) {
+      t.notOk(err, 'no error')
+      one.drop(function (err) {
+        t.notOk(err, 'no error')
+        two.get('0', function (err) {
+          t.ok(/has been dropped/.test(err && err.message), 'the other handle fails')
+          t.throws(two.iterator.bind(two), /has been dropped/, 'iterator() throws')
+          other.put('x', 'y', function (err) {
+            t.notOk(err, 'another sub-db is fine')
+            var again = db.subdb('same')
+            count(again, function (err, keys) {
+              t.notOk(err, 'no error')
+              t.equal(keys.length, 0, 'opened again, empty')
+              one.put('x', 'y', function (err) {
+                t.ok(err, 'the dropped handle still fails')
+                db.close(t.end.bind(t))
+              })
+            })
+          })
+        })
+      })
+    })
+  })
+})
+
+test('test drop() of the main db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    db.binding.drop({}, function (err) {
+      t.ok(err, 'errors')
+      t.ok(/requires a sub-database/.test(err.message), 'with a message')
+      db.close(t.end.bind(t))
+    })
+  })
+})
+
+test('tearDown', function (t) {
+  testCommon.tearDown(t)
+})
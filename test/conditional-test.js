@@ -0,0 +1,115 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open(t.end.bind(t))
+})
+
+test('test put() with ifAbsent', function (t) {
+  db.put('a', '1', { ifAbsent: true }, function (err, applied) {
+    t.notOk(err, 'no error')
+    t.equal(applied, true, 'written')
+    db.put('a', '2', { ifAbsent: true }, function (err, applied) {
+      t.notOk(err, 'no error')
+      t.equal(applied, false, 'not written')
+      db.get('a', { asBuffer: false }, function (err, value) {
+        t.notOk(err, 'no error')
+        t.equal(value, '1', 'not overwritten')
+        t.end()
+      })
+    })
+  })
+})
+
+test('test put() of a string with ifAbsent on an existing key', function (t) {
+  var pending = 10
+
+  // each is the string copy made for the write, which is freed afterwards
+  for (var i = 0; i < 10; i++) {
+    db.put('a', 'not written ' + i, { ifAbsent: true }, function (err, applied) {
+      t.notOk(err, 'no error')
+      t.equal(applied, false, 'not written')
+      if (--pending > 0)
+        return
+      db.get('a', { asBuffer: false }, function (err, value) {
+        t.notOk(err, 'no error')
+        t.equal(value, '1', 'not overwritten')
+        t.end()
+      })
+    })
+  }
+})
+
+test('test put() with ifEquals', function (t) {
+  db.put('a', '2', { ifEquals: '0' }, function (err, applied) {
+    t.notOk(err, 'no error')
+    t.equal(applied, false, 'different value, not written')
+    db.put('a', '2', { ifEquals: new Buffer('1') }, function (err, applied) {
+      t.notOk(err, 'no error')
+      t.equal(applied, true, 'swapped')
+      db.put('missing', 'x', { ifEquals: 'x' }, function (err, applied) {
+        t.notOk(err, 'no error')
+        t.equal(applied, false, 'missing key never equals')
+        db.get('a', { asBuffer: false }, function (err, value) {
+          t.notOk(err, 'no error')
+          t.equal(value, '2')
+          t.end()
+        })
+      })
+    })
+  })
+})
+
+test('test concurrent ifEquals puts, one wins', function (t) {
+  var results = []
+
+  function done (err, applied) {
+    t.notOk(err, 'no error')
+    results.push(applied)
+    if (results.length == 3) {
+      t.deepEqual(results.sort(), [ false, false, true ], 'exactly one swap')
+      t.end()
+    }
+  }
+
+  db.put('a', 'x', { ifEquals: '2' }, done)
+  db.put('a', 'y', { ifEquals: '2' }, done)
+  db.put('a', 'z', { ifEquals: '2' }, done)
+})
+
+test('test batch() with conditions', function (t) {
+  db.batch([
+      { type: 'put', key: 'b', value: '1', ifAbsent: true }
+    , { type: 'put', key: 'b', value: '2', ifAbsent: true }
+    , { type: 'put', key: 'c', value: '1' }
+    , { type: 'del', key: 'c', ifEquals: 'nope' }
+    , { type: 'put', key: 'c', value: '3', ifEquals: '1' }
+    , { type: 'del', key: 'zzz' }
+  ], function (err, applied) {
+    t.notOk(err, 'no error')
+    t.deepEqual(applied, [ true, false, true, false, true, false ])
+    db.getMany([ 'b', 'c' ], { asBuffer: false }, function (err, values) {
+      t.notOk(err, 'no error')
+      t.deepEqual(values, [ '1', '3' ])
+      t.end()
+    })
+  })
+})
+
+test('test batch() without conditions calls back with no results', function (t) {
+  db.batch([ { type: 'put', key: 'd', value: '1' } ], function (err, applied) {
+    t.notOk(err, 'no error')
+    t.equal(applied, undefined)
+    t.end()
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
@@ -0,0 +1,145 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+function key (i) {
+  return 'k' + ('0000' + i).slice(-4)
+}
+
+function fill (db, n, callback) {
+  var ops = []
+  for (var i = 0; i < n; i++)
+    ops.push({ type: 'put', key: key(i), value: 'v' + i })
+  db.batch(ops, callback)
+}
+
+function keys (db, callback) {
+  var it = db.iterator({ keyAsBuffer: false, values: false })
+    , found = []
+
+  function next () {
+    it.next(function (err, key) {
+      if (err || key === undefined)
+        return it.end(function () { callback(err, found) })
+      found.push(key)
+      next()
+    })
+  }
+  next()
+}
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    fill(db, 1000, t.end.bind(t))
+  })
+})
+
+test('test delRange() requires a callback', function (t) {
+  t.throws(db.delRange.bind(db), /requires a callback/)
+  t.throws(db.delRange.bind(db, {}), /requires a callback/)
+  t.end()
+})
+
+test('test delRange() with gte & lt', function (t) {
+  db.delRange({ gte: key(100), lt: key(200) }, function (err, count) {
+    t.notOk(err, 'no error')
+    t.equal(count, 100, 'deleted 100')
+    keys(db, function (err, found) {
+      t.notOk(err, 'no error')
+      t.equal(found.length, 900)
+      t.equal(found[99], key(99))
+      t.equal(found[100], key(200))
+      t.end()
+    })
+  })
+})
+
+test('test delRange() with gt & lte', function (t) {
+  db.delRange({ gt: key(300), lte: key(400) }, function (err, count) {
+    t.notOk(err, 'no error')
+    t.equal(count, 100, 'deleted 100')
+    db.get(key(300), function (err) {
+      t.notOk(err, 'gt is exclusive')
+      db.get(key(400), function (err) {
+        t.ok(err, 'lte is inclusive')
+        t.end()
+      })
+    })
+  })
+})
+
+test('test delRange() of an empty range', function (t) {
+  db.delRange({ gte: key(100), lt: key(200) }, function (err, count) {
+    t.notOk(err, 'no error')
+    t.equal(count, 0, 'nothing to delete')
+    t.end()
+  })
+})
+
+test('test delRange() in small chunks', function (t) {
+  db.delRange({ gte: key(500), chunkSize: 7 }, function (err, count) {
+    t.notOk(err, 'no error')
+    t.equal(count, 500, 'counted across chunks')
+    keys(db, function (err, found) {
+      t.notOk(err, 'no error')
+      t.equal(found.length, 300)
+      t.equal(found[found.length - 1], key(499))
+      t.end()
+    })
+  })
+})
+
+test('test writes interleave with a chunked delRange()', function (t) {
+  var done = 0
+
+  fill(db, 1000, function (err) {
+    t.notOk(err, 'no error')
+    db.delRange({ lt: 'l', chunkSize: 10 }, function (err, count) {
+      t.notOk(err, 'no error')
+      t.equal(count, 1000, 'deleted the range')
+      t.equal(done, 1, 'put completed first')
+      t.end()
+    })
+    db.put('zzz', 'v', function (err) {
+      t.notOk(err, 'no error')
+      done++
+    })
+  })
+})
+
+test('test delRange() in a sub-db', function (t) {
+  var sdb = lmdb(testCommon.location())
+  sdb.open({ maxDbs: 1 }, function (err) {
+    t.notOk(err, 'no error')
+    var sub = sdb.subdb('sub')
+    fill(sdb, 10, function (err) {
+      t.notOk(err, 'no error')
+      fill(sub, 10, function (err) {
+        t.notOk(err, 'no error')
+        sub.delRange({ lt: key(5) }, function (err, count) {
+          t.notOk(err, 'no error')
+          t.equal(count, 5)
+          sdb.delRange(function (err, count) {
+            t.notOk(err, 'no error')
+            t.equal(count, 10, 'skips the sub-db name')
+            keys(sdb, function (err, found) {
+              t.notOk(err, 'no error')
+              t.deepEqual(found, [ 'sub' ])
+              sdb.close(t.end.bind(t))
+            })
+          })
+        })
+      })
+    })
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
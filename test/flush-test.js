@@ -0,0 +1,39 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+test('setUp common', testCommon.setUp)
+
+test('test a sync write under metaSync: false waits for a flush', function (t) {
+  var db    = lmdb(testCommon.location())
+    , order = []
+
+  db.open({ metaSync: false, flushInterval: 500 }, function (err) {
+    t.notOk(err, 'no error')
+    db.put('durable', 'a', { sync: true }, function (err) {
+      t.notOk(err, 'no error')
+      order.push('sync')
+      t.deepEqual(order, [ 'visible', 'sync' ], 'after the later visible write')
+      db.close(t.end.bind(t))
+    })
+    // committed after the sync write but called back as soon as it is
+    db.put('visible', 'b', function (err) {
+      t.notOk(err, 'no error')
+      order.push('visible')
+    })
+  })
+})
+
+test('test flushInterval: 0 still flushes', function (t) {
+  var db = lmdb(testCommon.location())
+
+  db.open({ metaSync: false, flushInterval: 0 }, function (err) {
+    t.notOk(err, 'no error')
+    db.put('durable', 'a', { sync: true }, function (err) {
+      t.notOk(err, 'no error')
+      db.close(t.end.bind(t))
+    })
+  })
+})
+
+test('tearDown', testCommon.tearDown)
@@ -0,0 +1,66 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    db.batch([
+        { type: 'put', key: 'a', value: 'A' }
+      , { type: 'put', key: 'c', value: 'C' }
+      , { type: 'put', key: 'e', value: 'E' }
+    ], t.end.bind(t))
+  })
+})
+
+test('test getMany() requires an array of keys', function (t) {
+  db.getMany('a', function (err) {
+    t.ok(err, 'got error')
+    t.end()
+  })
+})
+
+test('test getMany() rejects null keys', function (t) {
+  db.getMany([ 'a', null ], function (err) {
+    t.ok(err, 'got error')
+    t.end()
+  })
+})
+
+test('test getMany() returns values in order of keys', function (t) {
+  db.getMany([ 'e', 'b', 'a', 'c' ], function (err, values) {
+    t.notOk(err, 'no error')
+    t.equal(values.length, 4, 'one result per key')
+    t.ok(Buffer.isBuffer(values[0]), 'values are Buffers by default')
+    t.equal(values[0].toString(), 'E')
+    t.equal(values[1], undefined, 'missing key is undefined')
+    t.equal(values[2].toString(), 'A')
+    t.equal(values[3].toString(), 'C')
+    t.end()
+  })
+})
+
+test('test getMany() with sort & asBuffer=false', function (t) {
+  db.getMany([ 'e', 'b', 'a', 'c', 'a' ], { sort: true, asBuffer: false }, function (err, values) {
+    t.notOk(err, 'no error')
+    t.deepEqual(values, [ 'E', undefined, 'A', 'C', 'A' ])
+    t.end()
+  })
+})
+
+test('test getMany() with no keys', function (t) {
+  db.getMany([], function (err, values) {
+    t.notOk(err, 'no error')
+    t.deepEqual(values, [])
+    t.end()
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
@@ -0,0 +1,108 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+function collect (iterator, callback) {
+  var keys = []
+  ;(function next () {
+    iterator.next(function (err, key) {
+      if (err)
+        return callback(err)
+      if (key === undefined)
+        return iterator.end(function (err) { callback(err, keys) })
+      keys.push(key)
+      next()
+    })
+  })()
+}
+
+// value: a uint32be score, then a tag
+function value (score, tag) {
+  var v = new Buffer(4 + tag.length)
+  v.writeUInt32BE(score, 0)
+  v.write(tag, 4)
+  return v
+}
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    db.batch([
+        { type: 'put', key: 'a:1', value: value(10, 'red') }
+      , { type: 'put', key: 'a:2', value: value(20, 'blue') }
+      , { type: 'put', key: 'a:3', value: value(30, 'reddish') }
+      , { type: 'put', key: 'b:1', value: value(40, 'red') }
+      , { type: 'put', key: 'b:2', value: value(50, 'green') }
+      , { type: 'put', key: 'c', value: 'x' }
+    ], t.end.bind(t))
+  })
+})
+
+test('test invalid filters throw', function (t) {
+  t.throws(db.iterator.bind(db, { filter: 'a' }), /must be an object/)
+  t.throws(db.iterator.bind(db, { filter: {} }), /needs a prefix/)
+  t.throws(db.iterator.bind(db, { filter: { prefix: 'a', on: 'both' } }), /`on`/)
+  t.throws(db.iterator.bind(db, { filter: { field: { type: 'int24' } } }), /unknown field type/)
+  t.throws(db.iterator.bind(db, { filter: { field: { type: 'uint8' }, gt: 'a' } }), /must be numbers/)
+  t.end()
+})
+
+test('test prefix filter', function (t) {
+  collect(db.iterator({ keyAsBuffer: false, filter: { prefix: 'b:' } }), function (err, keys) {
+    t.notOk(err, 'no error')
+    t.deepEqual(keys, ['b:1', 'b:2'])
+    t.end()
+  })
+})
+
+test('test equals & contains filters on values', function (t) {
+  collect(db.iterator({ keyAsBuffer: false, filter: { equals: 'red', at: 4, on: 'value' } }), function (err, keys) {
+    t.notOk(err, 'no error')
+    t.deepEqual(keys, ['a:1', 'a:3', 'b:1'], 'equals at')
+    collect(db.iterator({ keyAsBuffer: false, filter: { contains: 'e', on: 'value' } }), function (err, keys) {
+      t.notOk(err, 'no error')
+      t.deepEqual(keys, ['a:1', 'a:2', 'a:3', 'b:1', 'b:2'], 'contains')
+      t.end()
+    })
+  })
+})
+
+test('test field filter', function (t) {
+  var field = { offset: 0, type: 'uint32be' }
+  collect(db.iterator({ keyAsBuffer: false, filter: { field: field, on: 'value', gt: 10, lte: 40 } }), function (err, keys) {
+    t.notOk(err, 'no error')
+    t.deepEqual(keys, ['a:2', 'a:3', 'b:1'], 'between, too short skipped')
+    collect(db.iterator({ keyAsBuffer: false, filter: { field: field, on: 'value', eq: 50 } }), function (err, keys) {
+      t.notOk(err, 'no error')
+      t.deepEqual(keys, ['b:2'], 'eq')
+      t.end()
+    })
+  })
+})
+
+test('test filters combined, with a range, limit & reverse', function (t) {
+  collect(db.iterator({
+      keyAsBuffer: false
+    , lt: 'b:2'
+    , reverse: true
+    , limit: 2
+    , highWaterMark: 1
+    , filter: [
+          { contains: 'red', on: 'value' }
+        , { field: { offset: 0, type: 'uint32be' }, on: 'value', gte: 10 }
+      ]
+  }), function (err, keys) {
+    t.notOk(err, 'no error')
+    t.deepEqual(keys, ['b:1', 'a:3'], 'only matches count toward the limit')
+    t.end()
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
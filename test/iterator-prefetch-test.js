@@ -0,0 +1,145 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+  , count = 1000
+
+function key (i) {
+  return 'key' + ('000' + i).slice(-4)
+}
+
+function scan (iterator, each, callback) {
+  var keys = []
+  ;(function next () {
+    iterator.next(function (err, key) {
+      if (err)
+        return callback(err)
+      if (key === undefined)
+        return iterator.end(function (err) { callback(err, keys) })
+      keys.push(key)
+      each(keys.length, next)
+    })
+  })()
+}
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    var ops = []
+    for (var i = 0; i < count; i++)
+      ops.push({ type: 'put', key: key(i), value: 'value of ' + key(i) })
+    db.batch(ops, t.end.bind(t))
+  })
+})
+
+test('test prefetchBytes reads everything once, in order', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 256, prefetchBytes: 512 })
+
+  scan(iterator, function (n, next) {
+    // a slow consumer now & then, so batches are read ahead & waiting
+    if (n % 100 === 0)
+      return setTimeout(next, 5)
+    next()
+  }, function (err, keys) {
+    t.notOk(err, 'no error')
+    t.equal(keys.length, count, 'all of them')
+    t.equal(keys[0], key(0), 'first')
+    t.equal(keys[count - 1], key(count - 1), 'last')
+    for (var i = 1; i < keys.length; i++) {
+      if (keys[i] <= keys[i - 1])
+        return t.fail('out of order at ' + i)
+    }
+    t.end()
+  })
+})
+
+test('test prefetchBytes in reverse with a limit', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 64, prefetchBytes: 64, reverse: true, limit: 150 })
+
+  scan(iterator, function (n, next) { next() }, function (err, keys) {
+    t.notOk(err, 'no error')
+    t.equal(keys.length, 150, 'up to the limit')
+    t.equal(keys[0], key(count - 1), 'first')
+    t.equal(keys[149], key(count - 150), 'last')
+    t.end()
+  })
+})
+
+test('test seek() discards what was read ahead', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 64, prefetchBytes: 64 })
+
+  iterator.next(function (err, first) {
+    t.notOk(err, 'no error')
+    t.equal(first, key(0), 'first')
+    iterator.seek(key(500))
+    iterator.next(function (err, after) {
+      t.notOk(err, 'no error')
+      t.equal(after, key(500), 'from the seek')
+      iterator.next(function (err, next) {
+        t.notOk(err, 'no error')
+        t.equal(next, key(501), 'and on')
+        iterator.end(t.end.bind(t))
+      })
+    })
+  })
+})
+
+test('test seek() straight after a next() loses nothing', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 1, prefetchBytes: 1 })
+    , n = 0
+
+  ;(function round () {
+    // the read ahead queued by each next() is usually still waiting
+    iterator.next(function (err) {
+      t.ifError(err)
+      var at = n * 100
+      iterator.seek(key(at))
+      iterator.next(function (err, found) {
+        t.ifError(err)
+        if (found !== key(at))
+          t.fail('after seek(' + key(at) + ') got ' + found)
+        if (++n < 10)
+          return round()
+        iterator.end(t.end.bind(t))
+      })
+    })
+  })()
+})
+
+test('test a read ahead dropped by seek() doesn\'t count toward the limit', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 1, prefetchBytes: 1, limit: 5 })
+
+  iterator.next(function (err, first) {
+    t.notOk(err, 'no error')
+    t.equal(first, key(0), 'first')
+    // give the read ahead time to finish, so it's held & then dropped
+    setTimeout(function () {
+      iterator.seek(key(500))
+      scan(iterator, function (n, next) { next() }, function (err, keys) {
+        t.notOk(err, 'no error')
+        t.deepEqual(keys, [ key(500), key(501), key(502), key(503) ], 'the rest of the limit')
+        t.end()
+      })
+    }, 20)
+  })
+})
+
+test('test end() while reading ahead', function (t) {
+  var iterator = db.iterator({ highWaterMark: 64, prefetchBytes: 1 << 20 })
+
+  iterator.next(function (err) {
+    t.notOk(err, 'no error')
+    iterator.end(function (err) {
+      t.notOk(err, 'no error')
+      t.end()
+    })
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
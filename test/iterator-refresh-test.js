@@ -0,0 +1,164 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+// reads the whole iterator, calling `between` with each key before moving on
+function scan (iterator, between, callback) {
+  var keys = []
+  ;(function next () {
+    iterator.next(function (err, key) {
+      if (err)
+        return callback(err)
+      if (key === undefined)
+        return iterator.end(function (err) { callback(err, keys) })
+      keys.push(key)
+      between(key, next)
+    })
+  })()
+}
+
+function fill (callback) {
+  db.batch(['b', 'd', 'f', 'h'].map(function (key) {
+    return { type: 'put', key: key, value: key }
+  }), callback)
+}
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    fill(t.end.bind(t))
+  })
+})
+
+test('test without refresh, the scan is of one snapshot', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 1 })
+
+  scan(iterator, function (key, next) {
+    if (key != 'd')
+      return next()
+    db.batch([
+        { type: 'put', key: 'g', value: 'g' }
+      , { type: 'del', key: 'f' }
+    ], next)
+  }, function (err, keys) {
+    t.notOk(err, 'no error')
+    t.deepEqual(keys, ['b', 'd', 'f', 'h'], 'writes not seen')
+    db.batch([
+        { type: 'del', key: 'g' }
+      , { type: 'put', key: 'f', value: 'f' }
+    ], t.end.bind(t))
+  })
+})
+
+test('test refreshEntries, writes ahead are seen', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 1, refreshEntries: 1 })
+
+  scan(iterator, function (key, next) {
+    if (key != 'd')
+      return next()
+    db.batch([
+        { type: 'put', key: 'a', value: 'a' }
+      , { type: 'del', key: 'd' }
+      , { type: 'put', key: 'e', value: 'e' }
+      , { type: 'del', key: 'f' }
+    ], next)
+  }, function (err, keys) {
+    t.notOk(err, 'no error')
+    t.deepEqual(keys, ['b', 'd', 'e', 'h'], 'carried on past the deleted key')
+    db.batch([
+        { type: 'del', key: 'a' }
+      , { type: 'del', key: 'e' }
+    ], function (err) {
+      t.notOk(err, 'no error')
+      fill(t.end.bind(t))
+    })
+  })
+})
+
+test('test refreshEntries in reverse', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 1, refreshEntries: 1, reverse: true })
+
+  scan(iterator, function (key, next) {
+    if (key != 'f')
+      return next()
+    db.batch([
+        { type: 'del', key: 'f' }
+      , { type: 'put', key: 'e', value: 'e' }
+      , { type: 'put', key: 'i', value: 'i' }
+    ], next)
+  }, function (err, keys) {
+    t.notOk(err, 'no error')
+    t.deepEqual(keys, ['h', 'f', 'e', 'd', 'b'], 'carried on past the deleted key')
+    db.batch([
+        { type: 'del', key: 'e' }
+      , { type: 'del', key: 'i' }
+      , { type: 'put', key: 'f', value: 'f' }
+    ], t.end.bind(t))
+  })
+})
+
+test('test refreshMs', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 1, refreshMs: 10 })
+
+  scan(iterator, function (key, next) {
+    if (key != 'b')
+      return next()
+    db.put('c', 'c', function (err) {
+      t.notOk(err, 'no error')
+      setTimeout(next, 20)
+    })
+  }, function (err, keys) {
+    t.notOk(err, 'no error')
+    t.deepEqual(keys, ['b', 'c', 'd', 'f', 'h'], 'write seen')
+    t.end()
+  })
+})
+
+test('test refresh with a limit and range', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 1, refreshEntries: 1, gt: 'b', lte: 'h', limit: 3 })
+
+  scan(iterator, function (key, next) {
+    if (key != 'c')
+      return next()
+    db.put('cc', 'cc', next)
+  }, function (err, keys) {
+    t.notOk(err, 'no error')
+    t.deepEqual(keys, ['c', 'cc', 'd'], 'range & limit still hold')
+    t.end()
+  })
+})
+
+test('test refresh, seek() once run out', function (t) {
+  var iterator = db.iterator({ keyAsBuffer: false, highWaterMark: 1, refreshEntries: 1 })
+
+  ;(function drain () {
+    iterator.next(function (err, key) {
+      t.notOk(err, 'no error')
+      if (key !== undefined)
+        return drain()
+      // the txn was let go of, seek() renews it on the latest data
+      db.put('e', 'e', function (err) {
+        t.notOk(err, 'no error')
+        iterator.seek('d')
+        iterator.next(function (err, key) {
+          t.notOk(err, 'no error')
+          t.equal(key, 'd', 'seek()ed back')
+          iterator.next(function (err, key) {
+            t.notOk(err, 'no error')
+            t.equal(key, 'e', 'write seen')
+            iterator.end(t.end.bind(t))
+          })
+        })
+      })
+    })
+  })()
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
@@ -55,3 +55,107 @@ test('test mapSize increase', function (t) {
     }
   })
 })
+
+test('test autoGrow grows the map instead of borking', function (t) {
+  var db      = lmdb(testCommon.location())
+    , puts    = 20
+    , resizes = []
+    , donePuts = 0
+    , done = function () {
+        if (++donePuts == puts) {
+          t.ok(resizes.length > 0, 'onMapResize called')
+          t.ok(resizes[0] > 10 << 20, 'with the new map size')
+          t.ok(+db.getProperty('mdb.map_resizes') >= resizes.length, 'resizes counted')
+          db.close(testCommon.tearDown.bind(null, t))
+        }
+      }
+
+  db.open({ autoGrow: true, onMapResize: function (size) { resizes.push(size) } }, function (err) {
+    t.notOk(err, 'no error')
+
+    for (var i = 0; i < puts; i++) {
+      (function (i) {
+        db.put(i, bigBlob, function (err) {
+          t.notOk(err, 'no error from large put #' + i)
+          done()
+        })
+      }(i))
+    }
+  })
+})
+
+test('test autoGrow stops at maxMapSize', function (t) {
+  var db   = lmdb(testCommon.location())
+    , puts = 20
+    , fails = 0
+    , donePuts = 0
+    , done = function () {
+        if (++donePuts == puts) {
+          t.ok(fails > 0 && fails < puts, 'got some fails (' + fails + ')')
+          t.equal(+db.getProperty('mdb.mapsize'), 15 << 20, 'grown to maxMapSize')
+          db.close(testCommon.tearDown.bind(null, t))
+        }
+      }
+
+  db.open({ autoGrow: true, maxMapSize: 15 << 20 }, function (err) {
+    t.notOk(err, 'no error')
+
+    for (var i = 0; i < puts; i++) {
+      (function (i) {
+        db.put(i, bigBlob, function (err) {
+          err && fails++
+          done()
+        })
+      }(i))
+    }
+  })
+})
+
+test('test autoGrow under an open iterator', function (t) {
+  var db = lmdb(testCommon.location())
+
+  db.open({ autoGrow: true }, function (err) {
+    t.notOk(err, 'no error')
+
+    var ops = []
+    for (var i = 0; i < 1000; i++)
+      ops.push({ type: 'put', key: 'key' + (1000 + i), value: 'value' + i })
+
+    db.batch(ops, function (err) {
+      t.notOk(err, 'no error from batch')
+
+      var iterator = db.iterator({ keyAsBuffer: false, valueAsBuffer: false, highWaterMark: 1 })
+        , seen     = 0
+
+      iterator.next(function (err, key) {
+        t.notOk(err, 'no error from next()')
+        t.equal(key, 'key1000', 'first key')
+        seen++
+
+        var puts = 0
+        for (var j = 0; j < 20; j++) {
+          db.put('blob' + j, bigBlob, function (err) {
+            t.notOk(err, 'no error from large put')
+            if (++puts < 20)
+              return
+            t.ok(+db.getProperty('mdb.map_resizes') > 0, 'map was resized')
+            iterator.next(next)
+          })
+        }
+      })
+
+      function next (err, key, value) {
+        t.notOk(err, 'no error from next()')
+        if (key === undefined) {
+          t.equal(seen, 1000, 'saw every entry in the snapshot')
+          return iterator.end(function () {
+            db.close(testCommon.tearDown.bind(null, t))
+          })
+        }
+        t.equal(key, 'key' + (1000 + seen), 'entries in order')
+        seen++
+        iterator.next(next)
+      }
+    })
+  })
+})
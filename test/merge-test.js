@@ -0,0 +1,120 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+function int64 (n) {
+  var buf = new Buffer(8)
+  buf.writeInt32LE(n, 0)
+  buf.writeInt32LE(n < 0 ? -1 : 0, 4)
+  return buf
+}
+
+function readInt64 (buf) {
+  return buf.readInt32LE(4) * 0x100000000 + buf.readUInt32LE(0)
+}
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open(t.end.bind(t))
+})
+
+test('test batch() add', function (t) {
+  db.batch([
+      { type: 'add', key: 'count', value: 5 }
+    , { type: 'add', key: 'count', value: int64(-2) }
+    , { type: 'add', key: 'count', value: 10 }
+  ], function (err) {
+    t.notOk(err, 'no error')
+    db.get('count', function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value.length, 8, 'an Int64LE')
+      t.equal(readInt64(value), 13)
+      t.end()
+    })
+  })
+})
+
+test('test concurrent add batches all apply', function (t) {
+  var pending = 100
+
+  for (var i = 0; i < 100; i++) {
+    db.batch([ { type: 'add', key: 'hits', value: 1 } ], function (err) {
+      t.error(err)
+      if (--pending === 0) {
+        db.get('hits', function (err, value) {
+          t.notOk(err, 'no error')
+          t.equal(readInt64(value), 100)
+          t.end()
+        })
+      }
+    })
+  }
+})
+
+test('test batch() add to a value that isn\'t a counter', function (t) {
+  db.put('text', 'hello', function (err) {
+    t.notOk(err, 'no error')
+    db.batch([ { type: 'add', key: 'text', value: 1 } ], function (err) {
+      t.ok(/MDB_BAD_VALSIZE/.test(err.message), 'errors')
+      t.end()
+    })
+  })
+})
+
+test('test batch() append', function (t) {
+  db.batch([
+      { type: 'append', key: 'log', value: 'a' }
+    , { type: 'append', key: 'log', value: new Buffer('bc') }
+  ], function (err) {
+    t.notOk(err, 'no error')
+    db.get('log', { asBuffer: false }, function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value, 'abc')
+      t.end()
+    })
+  })
+})
+
+test('test batch() max & min', function (t) {
+  db.batch([
+      { type: 'max', key: 'hi', value: 'b' }
+    , { type: 'max', key: 'hi', value: 'a' }
+    , { type: 'max', key: 'hi', value: 'ba' }
+    , { type: 'min', key: 'lo', value: 'b' }
+    , { type: 'min', key: 'lo', value: 'c' }
+    , { type: 'max', key: 'num', value: 9 }
+    , { type: 'max', key: 'num', value: -20 }
+    , { type: 'max', key: 'num', value: 10 }
+  ], function (err) {
+    t.notOk(err, 'no error')
+    db.getMany([ 'hi', 'lo', 'num' ], function (err, values) {
+      t.notOk(err, 'no error')
+      t.equal(values[0].toString(), 'ba', 'max as bytes')
+      t.equal(values[1].toString(), 'b', 'min as bytes')
+      t.equal(readInt64(values[2]), 10, 'max as numbers')
+      t.end()
+    })
+  })
+})
+
+test('test batch() bitor', function (t) {
+  db.batch([
+      { type: 'bitor', key: 'bits', value: new Buffer([ 1 ]) }
+    , { type: 'bitor', key: 'bits', value: new Buffer([ 2, 4 ]) }
+  ], function (err) {
+    t.notOk(err, 'no error')
+    db.get('bits', function (err, value) {
+      t.notOk(err, 'no error')
+      t.deepEqual(Array.prototype.slice.call(value), [ 3, 4 ])
+      t.end()
+    })
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
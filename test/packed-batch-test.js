@@ -0,0 +1,102 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open({ maxDbs: 2 }, t.end.bind(t))
+})
+
+test('test packBatch() argument checks', function (t) {
+  t.throws(lmdb.packBatch.bind(null, 'foo'), /requires an array/)
+  t.throws(lmdb.packBatch.bind(null, [ { type: 'foo', key: 'a' } ]), /'put' or 'del'/)
+  t.throws(lmdb.packBatch.bind(null, [ { type: 'put', key: null, value: 'a' } ]), /key cannot be/)
+  t.throws(lmdb.packBatch.bind(null, [ { type: 'put', key: 'a' } ]), /value cannot be/)
+  t.end()
+})
+
+test('test packBatch() encoding', function (t) {
+  var packed = lmdb.packBatch([
+      { type: 'put', key: 'a', value: new Buffer([ 9 ]) }
+    , { type: 'del', key: 'b' }
+  ])
+  t.deepEqual(
+      Array.prototype.slice.call(packed)
+    , [ 1, 1, 0, 0, 0, 97, 1, 0, 0, 0, 9, 2, 1, 0, 0, 0, 98 ]
+  )
+  t.end()
+})
+
+test('test batch() with a packed batch', function (t) {
+  var ops = []
+  for (var i = 0; i < 1000; i++)
+    ops.push({ type: 'put', key: 'k' + i, value: 'v' + i })
+  ops.push({ type: 'del', key: 'k5' })
+  ops.push({ type: 'del', key: 'missing' })
+
+  db.batch(lmdb.packBatch(ops), function (err) {
+    t.notOk(err, 'no error')
+    db.getMany([ 'k0', 'k5', 'k999' ], { asBuffer: false }, function (err, values) {
+      t.notOk(err, 'no error')
+      t.deepEqual(values, [ 'v0', undefined, 'v999' ])
+      t.end()
+    })
+  })
+})
+
+test('test a packed batch changed straight after batch()', function (t) {
+  var packed = lmdb.packBatch([ { type: 'put', key: 'reused', value: 'first' } ])
+
+  db.batch(packed, function (err) {
+    t.notOk(err, 'no error')
+    db.get('reused', { asBuffer: false }, function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value, 'first', 'as it was when batch() was called')
+      t.end()
+    })
+  })
+  // a length that would run off the end, were it read in the writer
+  packed.fill(0xff)
+})
+
+test('test batch() with a malformed packed batch', function (t) {
+  var packed = lmdb.packBatch([
+      { type: 'put', key: 'good', value: 'yes' }
+    , { type: 'put', key: 'bad', value: 'no' }
+  ])
+
+  db.batch(packed.slice(0, packed.length - 1), function (err) {
+    t.ok(/malformed/.test(err.message), 'errors')
+    db.get('good', function (err) {
+      t.ok(err, 'nothing written')
+      db.batch(new Buffer(0), function (err) {
+        t.notOk(err, 'empty is fine')
+        t.end()
+      })
+    })
+  })
+})
+
+test('test batch() of a packed batch into a subdb', function (t) {
+  var sub = db.subdb('packed')
+
+  sub.batch(lmdb.packBatch([ { type: 'put', key: 'a', value: 'sub' } ]), function (err) {
+    t.notOk(err, 'no error')
+    sub.get('a', { asBuffer: false }, function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value, 'sub')
+      db.get('a', function (err) {
+        t.ok(err, 'not in the main db')
+        t.end()
+      })
+    })
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
@@ -0,0 +1,108 @@
+const test       = require('tape')
+    , crypto     = require('crypto')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open({ mapSize: 64 << 20 }, t.end.bind(t))
+})
+
+test('test putParts() argument checks', function (t) {
+  t.throws(db.putParts.bind(db, 'foo', []), /requires a callback/)
+  db.putParts('foo', 'bar', function (err) {
+    t.ok(/requires an array of parts/.test(err.message), 'not an array')
+    db.putParts(null, [], function (err) {
+      t.ok(err, 'null key')
+      db.putParts('foo', [ 'a', 1 ], function (err) {
+        t.ok(/each part to be a string or Buffer/.test(err && err.message), 'not a part')
+        t.end()
+      })
+    })
+  })
+})
+
+test('test putParts() joins the parts', function (t) {
+  var parts = [ new Buffer('abc'), 'déf', new Buffer(0), new Buffer('g') ]
+
+  db.putParts('foo', parts, function (err) {
+    t.notOk(err, 'no error')
+    db.get('foo', { asBuffer: false }, function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value, 'abcdéfg')
+      t.end()
+    })
+  })
+})
+
+test('test putParts() with the array changed before the write', function (t) {
+  var parts = [ new Buffer('abc'), 'def' ]
+
+  db.putParts('changed', parts, function (err) {
+    t.notOk(err, 'no error')
+    db.get('changed', { asBuffer: false }, function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value, 'abcdef', 'as it was when putParts() was called')
+      t.end()
+    })
+  })
+  // the string's copy must still be freed, the Buffer kept alive
+  parts[0] = 'xyz'
+  parts[1] = new Buffer('uvw')
+})
+
+test('test putParts() with a large value', function (t) {
+  var parts = []
+  for (var i = 0; i < 16; i++)
+    parts.push(crypto.randomBytes(256 * 1024))
+
+  db.putParts('big', parts, { sync: true }, function (err) {
+    t.notOk(err, 'no error')
+    db.get('big', function (err, value) {
+      t.notOk(err, 'no error')
+      t.ok(value.equals(Buffer.concat(parts)), 'same value')
+      t.end()
+    })
+  })
+})
+
+test('test batch() with parts', function (t) {
+  db.batch([
+      { type: 'put', key: 'a', value: [ 'one', new Buffer('two') ] }
+    , { type: 'put', key: 'b', value: 'three' }
+  ], function (err) {
+    t.notOk(err, 'no error')
+    db.getMany([ 'a', 'b' ], { asBuffer: false }, function (err, values) {
+      t.notOk(err, 'no error')
+      t.deepEqual(values, [ 'onetwo', 'three' ])
+      t.end()
+    })
+  })
+})
+
+test('test batch() with parts and ifAbsent', function (t) {
+  var parts = [ new Buffer('four'), 'five' ]
+
+  db.batch([
+      { type: 'put', key: 'a', value: [ 'seven' ], ifAbsent: true }
+    , { type: 'put', key: 'c', value: parts, ifAbsent: true }
+  ], function (err, applied) {
+    t.notOk(err, 'no error')
+    t.deepEqual(applied, [ false, true ])
+    db.getMany([ 'a', 'c' ], { asBuffer: false }, function (err, values) {
+      t.notOk(err, 'no error')
+      t.deepEqual(values, [ 'onetwo', 'fourfive' ])
+      t.end()
+    })
+  })
+  // the Buffer is held by the batch, the Array isn't needed
+  parts.length = 0
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
@@ -0,0 +1,133 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+
+function collect (iterator, callback) {
+  var entries = []
+  ;(function next () {
+    iterator.next(function (err, key, value) {
+      if (err)
+        return callback(err)
+      if (key === undefined)
+        return iterator.end(function (err) { callback(err, entries) })
+      entries.push(key + '=' + value)
+      next()
+    })
+  })()
+}
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  t.throws(db.snapshot.bind(db), /requires an open database/)
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    db.batch([
+        { type: 'put', key: 'a', value: '1' }
+      , { type: 'put', key: 'b', value: '2' }
+      , { type: 'put', key: 'c', value: '3' }
+    ], t.end.bind(t))
+  })
+})
+
+test('test reads on a snapshot don\'t see later writes', function (t) {
+  var snapshot = db.snapshot()
+
+  db.batch([
+      { type: 'put', key: 'a', value: 'changed' }
+    , { type: 'del', key: 'b' }
+    , { type: 'put', key: 'd', value: '4' }
+  ], function (err) {
+    t.notOk(err, 'no error')
+    db.get('a', { snapshot: snapshot, asBuffer: false }, function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value, '1', 'get() sees the old value')
+      db.get('a', { asBuffer: false }, function (err, value) {
+        t.notOk(err, 'no error')
+        t.equal(value, 'changed', 'without it, the new one')
+        db.getMany(['a', 'b', 'd'], { snapshot: snapshot, asBuffer: false, sort: true }, function (err, values) {
+          t.notOk(err, 'no error')
+          t.deepEqual(values, ['1', '2', undefined], 'getMany() too')
+          collect(db.iterator({ snapshot: snapshot }), function (err, entries) {
+            t.notOk(err, 'no error')
+            t.deepEqual(entries, ['a=1', 'b=2', 'c=3'], 'iterator() too')
+            snapshot.release()
+            t.end()
+          })
+        })
+      })
+    })
+  })
+})
+
+test('test concurrent reads on one snapshot', function (t) {
+  var snapshot = db.snapshot()
+    , pending  = 20
+
+  for (var i = 0; i < 20; i++) {
+    db.get('c', { snapshot: snapshot, asBuffer: false }, function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value, '3', 'the value')
+      if (--pending === 0) {
+        snapshot.release()
+        t.end()
+      }
+    })
+  }
+})
+
+test('test a released snapshot', function (t) {
+  var snapshot = db.snapshot()
+  snapshot.release()
+  snapshot.release()
+
+  db.get('a', { snapshot: snapshot }, function (err) {
+    t.ok(/released/.test(err && err.message), 'get() errors')
+    t.throws(db.iterator.bind(db, { snapshot: snapshot }), /released/, 'iterator() throws')
+    t.end()
+  })
+})
+
+test('test an iterator keeps its snapshot until ended', function (t) {
+  var snapshot = db.snapshot()
+    , iterator = db.iterator({ snapshot: snapshot, keyAsBuffer: false, valueAsBuffer: false })
+
+  snapshot.release()
+  db.put('c', 'changed', function (err) {
+    t.notOk(err, 'no error')
+    collect(iterator, function (err, entries) {
+      t.notOk(err, 'no error')
+      t.deepEqual(entries, ['a=changed', 'c=3', 'd=4'], 'the snapshot')
+      t.end()
+    })
+  })
+})
+
+test('test a snapshot of another database', function (t) {
+  var other = lmdb(testCommon.location())
+  other.open(function (err) {
+    t.notOk(err, 'no error')
+    var snapshot = other.snapshot()
+    db.get('a', { snapshot: snapshot }, function (err) {
+      t.ok(/another database/.test(err && err.message), 'errors')
+      snapshot.release()
+      other.close(t.end.bind(t))
+    })
+  })
+})
+
+test('test snapshot() with notls', function (t) {
+  var other = lmdb(testCommon.location())
+  other.open({ notls: true }, function (err) {
+    t.notOk(err, 'no error')
+    t.throws(other.snapshot.bind(other), /notls/)
+    other.close(t.end.bind(t))
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
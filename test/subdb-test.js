@@ -0,0 +1,148 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+  , users
+  , posts
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open({ maxDbs: 4 }, function (err) {
+    t.notOk(err, 'no error')
+    users = db.subdb('users')
+    posts = db.subdb('posts')
+    t.end()
+  })
+})
+
+test('test subdb() requires a name', function (t) {
+  t.throws(db.subdb.bind(db), /requires a name/)
+  t.throws(db.subdb.bind(db, ''), /requires a name/)
+  t.end()
+})
+
+test('test subdb() without create of a missing sub-db', function (t) {
+  t.throws(db.subdb.bind(db, 'missing', { create: false }), 'throws')
+  t.end()
+})
+
+test('test sub-dbs are separate keyspaces', function (t) {
+  users.put('a', 'user', function (err) {
+    t.notOk(err, 'no error')
+    posts.put('a', 'post', function (err) {
+      t.notOk(err, 'no error')
+      users.get('a', { asBuffer: false }, function (err, value) {
+        t.notOk(err, 'no error')
+        t.equal(value, 'user')
+        posts.get('a', { asBuffer: false }, function (err, value) {
+          t.notOk(err, 'no error')
+          t.equal(value, 'post')
+          db.get('a', function (err) {
+            t.ok(err, 'not in the main db')
+            t.end()
+          })
+        })
+      })
+    })
+  })
+})
+
+test('test batch() spans sub-dbs', function (t) {
+  db.batch([
+      { type: 'put', key: 'b', value: 'user b', subdb: users }
+    , { type: 'put', key: 'b', value: 'post b', subdb: posts }
+    , { type: 'del', key: 'a', subdb: posts }
+  ], function (err) {
+    t.notOk(err, 'no error')
+    users.get('b', { asBuffer: false }, function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value, 'user b')
+      posts.get('a', function (err) {
+        t.ok(err, 'deleted')
+        t.end()
+      })
+    })
+  })
+})
+
+test('test chained batch on a sub-db', function (t) {
+  users.batch().put('c', 'user c').del('b').write(function (err) {
+    t.notOk(err, 'no error')
+    users.get('c', { asBuffer: false }, function (err, value) {
+      t.notOk(err, 'no error')
+      t.equal(value, 'user c')
+      users.get('b', function (err) {
+        t.ok(err, 'deleted')
+        t.end()
+      })
+    })
+  })
+})
+
+test('test iterator on a sub-db', function (t) {
+  var iterator = posts.iterator({ keyAsBuffer: false, valueAsBuffer: false })
+    , entries  = []
+
+  function next () {
+    iterator.next(function (err, key, value) {
+      t.notOk(err, 'no error')
+      if (key === undefined) {
+        t.deepEqual(entries, [ [ 'b', 'post b' ] ], 'only its own entries')
+        return iterator.end(t.end.bind(t))
+      }
+      entries.push([ key, value ])
+      next()
+    })
+  }
+
+  next()
+})
+
+test('test getMany() on a sub-db', function (t) {
+  users.getMany([ 'a', 'missing' ], { asBuffer: false }, function (err, values) {
+    t.notOk(err, 'no error')
+    t.equal(values[0], 'user', 'from the sub-db')
+    t.equal(values[1], undefined, 'missing key is undefined')
+    posts.getMany([ 'a' ], function (err, values) {
+      t.notOk(err, 'no error')
+      t.equal(values[0].toString(), 'post', 'not the other sub-db')
+      t.end()
+    })
+  })
+})
+
+test('test approximateSize() on a sub-db', function (t) {
+  users.approximateSize('a', 'z', function (err, size) {
+    t.notOk(err, 'no error')
+    t.ok(size > 0, 'of the sub-db\'s entries')
+    t.end()
+  })
+})
+
+test('test subdb() with a callback', function (t) {
+  db.subdb('users', function (err, again) {
+    t.notOk(err, 'no error')
+    t.equal(again.id, users.id, 'same sub-db')
+    db.subdb('missing', { create: false }, function (err) {
+      t.ok(err, 'errors without create')
+      db.subdb('comments', function (err, comments) {
+        t.notOk(err, 'no error')
+        comments.put('c', 'comment c', function (err) {
+          t.notOk(err, 'no error')
+          comments.get('c', { asBuffer: false }, function (err, value) {
+            t.notOk(err, 'no error')
+            t.equal(value, 'comment c')
+            t.end()
+          })
+        })
+      })
+    })
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
@@ -0,0 +1,167 @@
+const test       = require('tape')
+    , crypto     = require('crypto')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+
+var db
+  , value = crypto.randomBytes(1024 * 1024 + 123)
+
+function collect (stream, callback) {
+  var chunks = []
+  stream.on('data', function (chunk) { chunks.push(chunk) })
+  stream.on('error', callback)
+  stream.on('end', function () { callback(null, chunks) })
+}
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open({ mapSize: 64 << 20 }, function (err) {
+    t.notOk(err, 'no error')
+    db.put('big', value, t.end.bind(t))
+  })
+})
+
+test('test getRange() argument checks', function (t) {
+  t.throws(db.getRange.bind(db, 'big', 0, 10), /requires a callback/)
+  db.getRange('big', -1, 10, function (err) {
+    t.ok(/non-negative offset/.test(err.message), 'negative offset')
+    db.getRange('big', 0, 'ten', function (err) {
+      t.ok(/non-negative length/.test(err.message), 'bad length')
+      t.end()
+    })
+  })
+})
+
+test('test getRange()', function (t) {
+  db.getRange('big', 1000, 5000, function (err, part, size) {
+    t.notOk(err, 'no error')
+    t.ok(part.equals(value.slice(1000, 6000)), 'the range')
+    t.equal(size, value.length, 'whole size')
+    db.getRange('big', value.length - 10, 100, function (err, part) {
+      t.notOk(err, 'no error')
+      t.ok(part.equals(value.slice(-10)), 'cut short at the end')
+      db.getRange('big', value.length + 10, 100, function (err, part) {
+        t.notOk(err, 'no error')
+        t.equal(part.length, 0, 'empty past the end')
+        db.getRange('big', 100, null, { zeroCopy: true }, function (err, part) {
+          t.notOk(err, 'no error')
+          t.ok(part.equals(value.slice(100)), 'to the end, zero-copy')
+          t.end()
+        })
+      })
+    })
+  })
+})
+
+test('test getRange() of a missing key', function (t) {
+  db.getRange('nope', 0, 10, function (err) {
+    t.ok(err, 'errors')
+    t.ok(/NotFound/i.test(err.message), 'not found')
+    t.end()
+  })
+})
+
+test('test createValueStream()', function (t) {
+  collect(db.createValueStream('big', { highWaterMark: 64 * 1024 }), function (err, chunks) {
+    t.notOk(err, 'no error')
+    t.ok(chunks.length > 1, 'in chunks')
+    t.ok(chunks[0].length <= 64 * 1024, 'of highWaterMark')
+    t.ok(Buffer.concat(chunks).equals(value), 'the whole value')
+    t.end()
+  })
+})
+
+test('test createValueStream() with zeroCopy', function (t) {
+  collect(db.createValueStream('big', { highWaterMark: 64 * 1024, zeroCopy: true }), function (err, chunks) {
+    t.notOk(err, 'no error')
+    t.ok(chunks.length > 1, 'in chunks')
+    t.ok(Buffer.concat(chunks).equals(value), 'the whole value')
+    t.equal(db._valueStreamMode({}), 'snapshot', 'not zero-copy unless asked')
+    t.end()
+  })
+})
+
+test('test createValueStream() sees one snapshot', function (t) {
+  var stream = db.createValueStream('big', { highWaterMark: 1024 })
+    , first  = true
+
+  collect(stream, function (err, chunks) {
+    t.notOk(err, 'no error')
+    t.ok(Buffer.concat(chunks).equals(value), 'not the overwrite')
+    t.end()
+  })
+  stream.once('data', function () {
+    db.put('big', 'overwritten', function (err) {
+      t.notOk(err, 'no error')
+    })
+  })
+})
+
+test('test createValueStream() of a missing key', function (t) {
+  collect(db.createValueStream('nope'), function (err) {
+    t.ok(err, 'errors')
+    t.end()
+  })
+})
+
+test('test createValueStream() with notls errors on a resized value', function (t) {
+  var notlsDb = lmdb(testCommon.location())
+
+  notlsDb.open({ mapSize: 64 << 20, notls: true }, function (err) {
+    t.notOk(err, 'no error')
+    notlsDb.put('big', value, function (err) {
+      t.notOk(err, 'no error')
+      var stream  = notlsDb.createValueStream('big', { highWaterMark: 1024 })
+        , pending = 2
+        , done    = function () {
+            if (--pending === 0)
+              notlsDb.close(t.end.bind(t))
+          }
+      collect(stream, function (err) {
+        t.ok(/changed while being streamed/.test(err && err.message), 'errors')
+        done()
+      })
+      stream.once('data', function () {
+        notlsDb.put('big', 'overwritten', function (err) {
+          t.notOk(err, 'no error')
+          done()
+        })
+      })
+    })
+  })
+})
+
+test('test createValueStream() with autoGrow lets the map grow', function (t) {
+  var growDb = lmdb(testCommon.location())
+
+  growDb.open({ mapSize: 1 << 20, autoGrow: true }, function (err) {
+    t.notOk(err, 'no error')
+    growDb.put('big', value.slice(0, 256 * 1024), function (err) {
+      t.notOk(err, 'no error')
+      var stream  = growDb.createValueStream('big', { highWaterMark: 1024 })
+        , pending = 2
+        , done    = function () {
+            if (--pending === 0)
+              growDb.close(t.end.bind(t))
+          }
+      collect(stream, function (err, chunks) {
+        t.notOk(err, 'no error')
+        t.ok(Buffer.concat(chunks).equals(value.slice(0, 256 * 1024)), 'the whole value')
+        done()
+      })
+      stream.once('data', function () {
+        // more than the map holds, it has to grow mid-stream
+        growDb.put('fill', crypto.randomBytes(2 << 20), function (err) {
+          t.notOk(err, 'grown, not MDB_MAP_FULL')
+          done()
+        })
+      })
+    })
+  })
+})
+
+test('tearDown', function (t) {
+  db.close(testCommon.tearDown.bind(null, t))
+})
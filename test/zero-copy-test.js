@@ -0,0 +1,101 @@
+const test       = require('tape')
+    , lmdb       = require('../')
+    , testCommon = require('abstract-leveldown/testCommon')
+    , crypto     = require('crypto')
+    , bigBlob    = crypto.randomBytes(200000)
+
+var db
+
+test('setUp common', testCommon.setUp)
+
+test('setUp db', function (t) {
+  db = lmdb(testCommon.location())
+  db.open(function (err) {
+    t.notOk(err, 'no error')
+    db.put('blob', bigBlob, t.end.bind(t))
+  })
+})
+
+test('test zeroCopy get()', function (t) {
+  db.get('blob', { zeroCopy: true }, function (err, value) {
+    t.notOk(err, 'no error')
+    t.ok(Buffer.isBuffer(value), 'value is a Buffer')
+    t.equal(value.toString('hex'), bigBlob.toString('hex'), 'value is correct')
+    t.end()
+  })
+})
+
+test('test zeroCopy get() on missing key', function (t) {
+  db.get('nope', { zeroCopy: true }, function (err) {
+    t.ok(err, 'got error')
+    t.ok(/notfound/i.test(err.message), 'is a NotFound error')
+    t.end()
+  })
+})
+
+test('test releaseBuffer()', function (t) {
+  db.get('blob', { zeroCopy: true }, function (err, value) {
+    t.notOk(err, 'no error')
+    t.equal(db.releaseBuffer(value.slice(1)), false, 'a slice is not released')
+    t.equal(db.releaseBuffer(value), true, 'released')
+    t.equal(db.releaseBuffer(value), false, 'not released twice')
+    t.equal(db.releaseBuffer(bigBlob), false, 'a copy is not released')
+    t.end()
+  })
+})
+
+test('test zeroCopy get()s kept past maxReaders', function (t) {
+  var values = []
+    , pending = 300
+
+  for (var i = 0; i < 300; i++) {
+    // a write between each, so no two reads can share a txn
+    db.put('other', String(i), function (err) {
+      t.notOk(err, 'no error')
+      db.get('blob', { zeroCopy: true }, function (err, value) {
+        t.notOk(err, 'no error')
+        values.push(value)
+        if (--pending > 0)
+          return
+        t.ok(values.every(function (v) { return v.equals(bigBlob) }), 'values are correct')
+        db.get('blob', function (err, value) {
+          t.notOk(err, 'other reads still work')
+          values.forEach(function (v) { db.releaseBuffer(v) })
+          t.end()
+        })
+      })
+    })
+  }
+})
+
+test('test zeroCopy is ignored with writeMap', function (t) {
+  var location = testCommon.location()
+    , wdb      = lmdb(location)
+
+  wdb.open({ writeMap: true }, function (err) {
+    t.notOk(err, 'no error')
+    wdb.put('blob', bigBlob, function (err) {
+      t.notOk(err, 'no error')
+      wdb.get('blob', { zeroCopy: true }, function (err, value) {
+        t.notOk(err, 'no error')
+        t.ok(value.equals(bigBlob), 'value is correct')
+        t.equal(wdb.releaseBuffer(value), false, 'value is a copy')
+        wdb.close(t.end.bind(t))
+      })
+    })
+  })
+})
+
+test('test zeroCopy value survives later writes & close', function (t) {
+  db.get('blob', { zeroCopy: true }, function (err, value) {
+    t.notOk(err, 'no error')
+    db.put('blob', 'overwritten', function (err) {
+      t.notOk(err, 'no error')
+      db.close(function (err) {
+        t.notOk(err, 'no error')
+        t.equal(value.toString('hex'), bigBlob.toString('hex'), 'snapshot value intact')
+        testCommon.tearDown(t)
+      })
+    })
+  })
+})
@@ -0,0 +1,101 @@
+const util     = require('util')
+    , Readable = require('stream').Readable
+
+
+// Streams a single value in chunks, see `LevelDOWN#createValueStream()`.
+// With `mode` 'pinned' the whole value is read zero-copy, held by one read
+// txn, and the chunks are slices of it straight out of the map; otherwise
+// each chunk is copied out by a getRange() of its own, from `snapshot` if
+// given, else with 'snapshot' from one of our own and with 'copy' from
+// whatever is there at the time
+function ValueStream (db, key, options, mode) {
+  if (typeof options != 'object' || options === null)
+    options = {}
+
+  Readable.call(this, { highWaterMark: options.highWaterMark })
+
+  this.db        = db
+  this.key       = key
+  this._chunk    = this._readableState.highWaterMark
+  this._pinned   = mode == 'pinned' && !options.snapshot
+  this._snapshot = mode == 'snapshot' && !options.snapshot
+    ? db.snapshot()
+    : null
+  this._options  = options.snapshot || this._snapshot
+    ? { snapshot: options.snapshot || this._snapshot }
+    : {}
+  this._value    = null
+  this._offset   = 0
+  this._size     = -1
+}
+
+util.inherits(ValueStream, Readable)
+
+
+ValueStream.prototype._read = function () {
+  var self = this
+
+  if (this._pinned) {
+    if (this._value !== null)
+      return this._pushSlice()
+
+    return this.db.getRange(this.key, 0, null, { zeroCopy: true }, function (err, value) {
+      if (err)
+        return self.emit('error', err)
+      self._value = value
+      self._pushSlice()
+    })
+  }
+
+  if (this._size != -1 && this._offset >= this._size)
+    return this._end()
+
+  this.db.getRange(this.key, this._offset, this._chunk, this._options, function (err, chunk, size) {
+    if (err)
+      return self._error(err)
+    // read outside of a snapshot, the value was written over part way
+    if (self._size != -1 && size != self._size)
+      return self._error(new Error('value changed while being streamed'))
+    if (chunk.length === 0)
+      return self._end()
+    self._size    = size
+    self._offset += chunk.length
+    self.push(chunk)
+  })
+}
+
+
+ValueStream.prototype._pushSlice = function () {
+  if (this._offset >= this._value.length) {
+    // let go of the pin as soon as we're done with it
+    this._value = null
+    return this.push(null)
+  }
+
+  var chunk = this._value.slice(this._offset, this._offset + this._chunk)
+  this._offset += chunk.length
+  this.push(chunk)
+}
+
+
+ValueStream.prototype._end = function () {
+  this._release()
+  this.push(null)
+}
+
+
+ValueStream.prototype._error = function (err) {
+  this._release()
+  this.emit('error', err)
+}
+
+
+ValueStream.prototype._release = function () {
+  if (this._snapshot === null)
+    return
+  this._snapshot.release()
+  this._snapshot = null
+}
+
+
+module.exports = ValueStream